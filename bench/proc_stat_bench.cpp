@@ -0,0 +1,124 @@
+// Micro-benchmark: istringstream tokenization vs parseProcStat on a /proc/PID/stat corpus.
+//
+// Usage:
+//   ./proc_stat_bench [corpus_dir] [iterations]
+//
+// Without a corpus directory the current /proc/*/stat files are captured into
+// memory once. To capture a corpus from a busy host:
+//   mkdir corpus && for p in /proc/[0-9]*; do cat $p/stat > corpus/${p#/proc/} 2>/dev/null; done
+#include "header.h"
+
+// The tokenizer getProcessList used before parseProcStat
+static bool parseWithStream(const string& line, Proc& proc)
+{
+    istringstream iss(line);
+    string token;
+    vector<string> tokens;
+
+    while (iss >> token) {
+        tokens.push_back(token);
+    }
+
+    if (tokens.size() < 24) return false;
+
+    proc.state = tokens[2].empty() ? '?' : tokens[2][0];
+    proc.vsize = stoll(tokens[22]);
+    proc.rss = stoll(tokens[23]);
+    proc.utime = stoll(tokens[13]);
+    proc.stime = stoll(tokens[14]);
+    proc.starttime = stoll(tokens[21]);
+    return true;
+}
+
+static vector<string> loadCorpus(const char* dirPath)
+{
+    vector<string> corpus;
+    char path[PATH_MAX];
+    char buf[1024];
+
+    DIR* dir = opendir(dirPath);
+    if (dir == nullptr) return corpus;
+
+    bool liveProc = strcmp(dirPath, "/proc") == 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] == '.') continue;
+        if (liveProc) {
+            if (strspn(entry->d_name, "0123456789") != strlen(entry->d_name)) continue;
+            snprintf(path, sizeof(path), "/proc/%s/stat", entry->d_name);
+        } else {
+            snprintf(path, sizeof(path), "%s/%s", dirPath, entry->d_name);
+        }
+
+        ssize_t len = readProcFile(path, buf, sizeof(buf));
+        if (len > 0) corpus.emplace_back(buf, len);
+    }
+
+    closedir(dir);
+    return corpus;
+}
+
+template <typename F>
+static double nsPerRecord(const vector<string>& corpus, int iterations, F parse)
+{
+    long long checksum = 0;
+    auto start = chrono::steady_clock::now();
+
+    for (int i = 0; i < iterations; i++) {
+        for (const auto& line : corpus) {
+            Proc proc = {0};
+            parse(line, proc);
+            checksum += proc.utime + proc.rss + proc.state;
+        }
+    }
+
+    double elapsed = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    // Keep the work observable so it is not optimized away
+    if (checksum == 42) printf(" ");
+    return elapsed / ((double)iterations * corpus.size());
+}
+
+int main(int argc, char** argv)
+{
+    const char* corpusDir = argc > 1 ? argv[1] : "/proc";
+    int iterations = argc > 2 ? atoi(argv[2]) : 200;
+
+    vector<string> corpus = loadCorpus(corpusDir);
+    if (corpus.empty()) {
+        fprintf(stderr, "No stat records found in %s\n", corpusDir);
+        return 1;
+    }
+
+    // Both parsers must agree before timing means anything. The stream path
+    // mis-tokenizes names with spaces, so those records are only counted.
+    int mismatches = 0;
+    int spacedNames = 0;
+    for (const auto& line : corpus) {
+        Proc a = {0};
+        Proc b = {0};
+        parseProcStat(line.data(), line.size(), b);
+        if (b.name.find(' ') != string::npos) {
+            spacedNames++;
+            continue;
+        }
+        parseWithStream(line, a);
+        if (a.state != b.state || a.utime != b.utime || a.stime != b.stime ||
+            a.starttime != b.starttime || a.vsize != b.vsize || a.rss != b.rss) {
+            mismatches++;
+        }
+    }
+
+    double streamNs = nsPerRecord(corpus, iterations, [](const string& line, Proc& proc) {
+        parseWithStream(line, proc);
+    });
+    double scanNs = nsPerRecord(corpus, iterations, [](const string& line, Proc& proc) {
+        parseProcStat(line.data(), line.size(), proc);
+    });
+
+    printf("corpus: %zu records from %s, %d iterations\n", corpus.size(), corpusDir, iterations);
+    printf("names with spaces: %d, mismatches: %d\n", spacedNames, mismatches);
+    printf("istringstream: %8.1f ns/record\n", streamNs);
+    printf("parseProcStat: %8.1f ns/record (%.1fx)\n", scanNs, streamNs / scanNs);
+
+    return mismatches == 0 ? 0 : 1;
+}
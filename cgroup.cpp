@@ -0,0 +1,438 @@
+#include "header.h"
+#include <sys/inotify.h>
+
+// cgroup v2 collector. The hierarchy is mirrored in CgroupTree::nodes and kept
+// current from inotify events; the per-cgroup files are read once per process
+// scan so the cgroup totals line up with the process table.
+
+struct CgroupField {
+    const char* key;
+    long long CgroupInfo::* field;
+};
+
+static const CgroupField cpuStatFields[] = {
+    {"usage_usec", &CgroupInfo::usageUsec},
+    {"user_usec", &CgroupInfo::userUsec},
+    {"system_usec", &CgroupInfo::systemUsec},
+    {"throttled_usec", &CgroupInfo::throttledUsec},
+};
+static const CgroupField memoryStatFields[] = {
+    {"anon", &CgroupInfo::memoryAnon},
+    {"file", &CgroupInfo::memoryFile},
+};
+
+// Directory of a cgroup path on disk
+static string cgroupDir(const string& root, const string& path)
+{
+    return path == "/" ? root : root + path;
+}
+
+// Read a cgroup file, growing buf until the whole file fits (memory.stat keeps getting longer)
+static ssize_t readCgroupFile(const string& dir, const char* name, vector<char>& buf)
+{
+    string path = dir + "/" + name;
+    ssize_t len;
+    while ((len = readProcFile(path.c_str(), buf.data(), buf.size())) == (ssize_t)buf.size() - 1) {
+        buf.resize(buf.size() * 2);
+    }
+    return len;
+}
+
+// "key value" lines, as in cpu.stat and memory.stat
+static void parseKeyedFile(const char* p, const char* end, const CgroupField* fields, size_t count, CgroupInfo& info)
+{
+    while (p < end) {
+        const char* eol = (const char*)memchr(p, '\n', end - p);
+        if (eol == nullptr) eol = end;
+        const char* space = (const char*)memchr(p, ' ', eol - p);
+        if (space != nullptr) {
+            size_t keyLength = space - p;
+            for (size_t i = 0; i < count; i++) {
+                if (strlen(fields[i].key) == keyLength && memcmp(p, fields[i].key, keyLength) == 0) {
+                    scanNumber(space + 1, eol, info.*fields[i].field);
+                    break;
+                }
+            }
+        }
+        p = eol + 1;
+    }
+}
+
+// io.stat: "8:0 rbytes=1459200 wbytes=314773504 rios=192 wios=353 dbytes=0 dios=0" per device
+static void parseIOStat(const char* p, const char* end, CgroupInfo& info)
+{
+    info.ioReadBytes = 0;
+    info.ioWriteBytes = 0;
+    while (p < end) {
+        const char* eol = (const char*)memchr(p, '\n', end - p);
+        if (eol == nullptr) eol = end;
+        for (const char* q = p; q < eol;) {
+            const char* next = (const char*)memchr(q, ' ', eol - q);
+            if (next == nullptr) next = eol;
+            long long value;
+            if (next - q > 7 && memcmp(q, "rbytes=", 7) == 0) {
+                scanNumber(q + 7, next, value);
+                info.ioReadBytes += value;
+            } else if (next - q > 7 && memcmp(q, "wbytes=", 7) == 0) {
+                scanNumber(q + 7, next, value);
+                info.ioWriteBytes += value;
+            }
+            q = next + 1;
+        }
+        p = eol + 1;
+    }
+}
+
+// cgroup.events: "populated 1\nfrozen 0\n"; the root has no such file and is always populated
+static bool readPopulated(const string& dir)
+{
+    char buf[128];
+    ssize_t len = readProcFile((dir + "/cgroup.events").c_str(), buf, sizeof(buf));
+    if (len <= 0) return true;
+    const char* key = strstr(buf, "populated ");
+    return key == nullptr || key[10] != '0';
+}
+
+// The cgroups are sorted by path, so a lookup is a binary search. -1 if absent.
+static int findCgroup(const vector<CgroupInfo>& cgroups, const string& path)
+{
+    auto it = lower_bound(cgroups.begin(), cgroups.end(), path,
+                          [](const CgroupInfo& cgroup, const string& key) { return cgroup.path < key; });
+    return it != cgroups.end() && it->path == path ? (int)(it - cgroups.begin()) : -1;
+}
+
+// The unified hierarchy line of /proc/PID/cgroup: "0::/system.slice/sshd.service"
+static bool readProcessCgroup(int pid, string& path)
+{
+    char procPath[64];
+    char buf[4096];
+    snprintf(procPath, sizeof(procPath), "/proc/%d/cgroup", pid);
+    ssize_t len = readProcFile(procPath, buf, sizeof(buf));
+    if (len <= 0) return false;
+
+    const char* p = buf;
+    const char* end = buf + len;
+    while (p < end) {
+        const char* eol = (const char*)memchr(p, '\n', end - p);
+        if (eol == nullptr) eol = end;
+        if (eol - p >= 4 && memcmp(p, "0::", 3) == 0) {
+            path.assign(p + 3, eol);
+            return true;
+        }
+        p = eol + 1;
+    }
+    return false;
+}
+
+CgroupTree::~CgroupTree()
+{
+    close();
+}
+
+// Find the cgroup2 mount (on hybrid systems it is /sys/fs/cgroup/unified) and
+// start inotify. Returns false without inotify, leaving refresh() to re-walk
+// the tree each time; collect() stays empty if there is no cgroup2 mount.
+bool CgroupTree::open()
+{
+    close();
+
+    vector<char> buf(16384);
+    int mountsFd = ::open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC);
+    if (mountsFd < 0) return false;
+    size_t len = 0;
+    while (true) {
+        if (len == buf.size()) buf.resize(buf.size() * 2);
+        ssize_t n = read(mountsFd, buf.data() + len, buf.size() - len);
+        if (n <= 0) break;
+        len += n;
+    }
+    ::close(mountsFd);
+
+    // id parent major:minor root mountpoint options [optional fields...] - fstype source superoptions
+    root.clear();
+    const char* p = buf.data();
+    const char* end = p + len;
+    while (p < end && root.empty()) {
+        const char* eol = (const char*)memchr(p, '\n', end - p);
+        if (eol == nullptr) eol = end;
+        if (memmem(p, eol - p, " - cgroup2 ", 11) != nullptr) {
+            // Skip to field 5, the mount point
+            const char* field = p;
+            for (int i = 0; i < 4 && field != nullptr; i++) {
+                field = (const char*)memchr(field, ' ', eol - field);
+                if (field != nullptr) field++;
+            }
+            const char* fieldEnd = field ? (const char*)memchr(field, ' ', eol - field) : nullptr;
+            if (fieldEnd != nullptr) root = unescapeMountField(field, fieldEnd);
+        }
+        p = eol + 1;
+    }
+    if (root.empty()) return false;
+
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    stale = true;
+    return active();
+}
+
+void CgroupTree::close()
+{
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    watches.clear();
+    eventsWatches.clear();
+    stale = true;
+}
+
+// Add a cgroup and everything below it. The watch goes in before readdir, so a
+// subgroup created meanwhile is either listed or reported as an event.
+void CgroupTree::addSubtree(const string& path)
+{
+    if (!nodes.emplace(path, Node()).second) return;
+    string dir = cgroupDir(root, path);
+
+    if (active()) {
+        int wd = inotify_add_watch(fd, dir.c_str(), IN_CREATE | IN_DELETE | IN_ONLYDIR);
+        if (wd < 0 && errno == ENOSPC) {
+            // Out of watches (fs.inotify.max_user_watches): re-walk from now on
+            fprintf(stderr, "cgroup: inotify watch limit reached, re-walking %s on every scan\n", root.c_str());
+            close();
+        } else if (wd >= 0) {
+            watches[wd] = path;
+            int eventsWd = inotify_add_watch(fd, (dir + "/cgroup.events").c_str(), IN_MODIFY);
+            if (eventsWd >= 0) eventsWatches[eventsWd] = path;
+        }
+    }
+    nodes[path].populated = readPopulated(dir);
+
+    DIR* cgroupDirectory = opendir(dir.c_str());
+    if (cgroupDirectory == nullptr) return;
+
+    string prefix = path == "/" ? "" : path;
+    struct dirent* entry;
+    while ((entry = readdir(cgroupDirectory)) != nullptr) {
+        if (entry->d_type != DT_DIR || entry->d_name[0] == '.') continue;
+        addSubtree(prefix + "/" + entry->d_name);
+    }
+    closedir(cgroupDirectory);
+}
+
+// Drop a removed cgroup and its descendants; the kernel drops their watches
+void CgroupTree::removeSubtree(const string& path)
+{
+    nodes.erase(path);
+    string prefix = path + "/";
+    auto it = nodes.lower_bound(prefix);
+    while (it != nodes.end() && it->first.compare(0, prefix.size(), prefix) == 0) {
+        it = nodes.erase(it);
+    }
+}
+
+void CgroupTree::refresh()
+{
+    if (root.empty()) return;
+
+    alignas(struct inotify_event) char buf[4096];
+    while (active() && !stale) {
+        ssize_t len = read(fd, buf, sizeof(buf));
+        if (len <= 0) break; // EAGAIN once the queue is drained
+
+        for (char* p = buf; p < buf + len;) {
+            const struct inotify_event* event = (const struct inotify_event*)p;
+            p += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                stale = true;
+                break;
+            }
+            if (event->mask & IN_IGNORED) {
+                watches.erase(event->wd);
+                eventsWatches.erase(event->wd);
+                continue;
+            }
+
+            auto dir = watches.find(event->wd);
+            if (dir != watches.end() && (event->mask & IN_ISDIR) && event->len > 0) {
+                string child = (dir->second == "/" ? "" : dir->second) + "/" + event->name;
+                if (event->mask & IN_CREATE) addSubtree(child);
+                if (event->mask & IN_DELETE) removeSubtree(child);
+                continue;
+            }
+
+            auto events = eventsWatches.find(event->wd);
+            if (events != eventsWatches.end()) {
+                auto node = nodes.find(events->second);
+                if (node != nodes.end()) {
+                    node->second.populated = readPopulated(cgroupDir(root, node->first));
+                }
+            }
+        }
+    }
+
+    // First refresh, lost events or no inotify: walk everything
+    if (!active() || stale) {
+        nodes.clear();
+        if (active()) {
+            // Watches on existing directories are handed back with the same descriptor
+            watches.clear();
+            eventsWatches.clear();
+        }
+        addSubtree("/");
+        stale = false;
+    }
+}
+
+// Read the accounting files of every known cgroup. A cgroup removed since the
+// last refresh simply keeps its counters at -1.
+vector<CgroupInfo> CgroupTree::collect()
+{
+    static vector<char> buf(16384);
+
+    vector<CgroupInfo> cgroups;
+    if (root.empty()) return cgroups;
+    cgroups.reserve(nodes.size());
+
+    for (const auto& node : nodes) {
+        CgroupInfo info;
+        info.path = node.first;
+        info.populated = node.second.populated;
+        if (info.path != "/") {
+            size_t slash = info.path.rfind('/');
+            info.parent = findCgroup(cgroups, slash == 0 ? string("/") : info.path.substr(0, slash));
+        }
+
+        string dir = cgroupDir(root, info.path);
+        ssize_t len = readCgroupFile(dir, "cpu.stat", buf);
+        if (len > 0) {
+            parseKeyedFile(buf.data(), buf.data() + len, cpuStatFields,
+                           sizeof(cpuStatFields) / sizeof(*cpuStatFields), info);
+        }
+        len = readCgroupFile(dir, "memory.current", buf);
+        if (len > 0) {
+            scanNumber(buf.data(), buf.data() + len, info.memoryCurrent);
+        }
+        len = readCgroupFile(dir, "memory.stat", buf);
+        if (len > 0) {
+            parseKeyedFile(buf.data(), buf.data() + len, memoryStatFields,
+                           sizeof(memoryStatFields) / sizeof(*memoryStatFields), info);
+        }
+        len = readCgroupFile(dir, "io.stat", buf);
+        if (len >= 0) {
+            parseIOStat(buf.data(), buf.data() + len, info);
+        }
+
+        cgroups.push_back(move(info));
+    }
+
+    return cgroups;
+}
+
+// Processes are moved between cgroups after they start (container runtimes,
+// systemd scopes) and nothing reports a single move, so a cached entry is
+// re-read when any of these holds:
+//   - the PID is new or was reused (starttime differs)
+//   - the process started less than youngSeconds ago
+//   - its cgroup is gone or no longer populated, so the process has left it
+//   - it is this PID's turn in the rolling revalidation, which re-reads every
+//     PID once per revalidateScans scans, so any other move shows up within
+//     that many scans
+// Churn elsewhere in the tree (containers and scopes coming and going) leaves
+// the cached entries of unrelated processes alone.
+static const double youngSeconds = 10.0;
+static const unsigned long revalidateScans = 20;
+
+void CgroupTree::assignProcesses(const vector<Proc>& processes, const vector<CgroupInfo>& cgroups, ProcessStore& store)
+{
+    store.cgroup.assign(store.size(), -1);
+    if (root.empty()) return;
+
+    // starttime counts clock ticks since boot
+    static const long ticksPerSecond = sysconf(_SC_CLK_TCK);
+    struct timespec boot;
+    clock_gettime(CLOCK_BOOTTIME, &boot);
+    long long youngSince = (long long)((boot.tv_sec + boot.tv_nsec / 1e9 - youngSeconds) * ticksPerSecond);
+    scans++;
+
+    unordered_map<int, CachedCgroup> current;
+    current.reserve(processes.size());
+    for (size_t i = 0; i < processes.size() && i < store.size(); i++) {
+        const Proc& proc = processes[i];
+        CachedCgroup entry = {proc.starttime, string()};
+        int index = -1;
+
+        auto cached = pidCgroups.find(proc.pid);
+        if (cached != pidCgroups.end() && cached->second.starttime == proc.starttime &&
+            proc.starttime < youngSince && (scans + proc.pid) % revalidateScans != 0) {
+            entry = move(cached->second);
+            index = findCgroup(cgroups, entry.path);
+            if (index >= 0 && !cgroups[index].populated) index = -1;
+        }
+        if (index < 0 && readProcessCgroup(proc.pid, entry.path)) {
+            index = findCgroup(cgroups, entry.path);
+        }
+
+        store.cgroup[i] = index;
+        if (!entry.path.empty()) current.emplace(proc.pid, move(entry));
+    }
+
+    // Exited processes drop out here because only live PIDs are kept
+    pidCgroups.swap(current);
+}
+
+// CPU% of one core and I/O bytes per second from the previous sample. New
+// cgroups start at zero; a zero-length interval keeps the previous rates.
+void computeCgroupRates(vector<CgroupInfo>& current, const vector<CgroupInfo>& previous, double elapsed)
+{
+    for (auto& cgroup : current) {
+        int prevIndex = findCgroup(previous, cgroup.path);
+        cgroup.cpu = cgroup.ioReadRate = cgroup.ioWriteRate = 0.0;
+        if (prevIndex < 0) continue;
+
+        const CgroupInfo& prev = previous[prevIndex];
+        if (elapsed <= 0.0) {
+            cgroup.cpu = prev.cpu;
+            cgroup.ioReadRate = prev.ioReadRate;
+            cgroup.ioWriteRate = prev.ioWriteRate;
+            continue;
+        }
+
+        if (cgroup.usageUsec >= 0 && prev.usageUsec >= 0) {
+            cgroup.cpu = counterDelta(prev.usageUsec, cgroup.usageUsec) / (elapsed * 1e6) * 100.0;
+        }
+        if (cgroup.ioReadBytes >= 0 && prev.ioReadBytes >= 0) {
+            cgroup.ioReadRate = counterDelta(prev.ioReadBytes, cgroup.ioReadBytes) / elapsed;
+            cgroup.ioWriteRate = counterDelta(prev.ioWriteBytes, cgroup.ioWriteBytes) / elapsed;
+        }
+    }
+}
+
+// Each process counts towards its own cgroup, then a single pass from the last
+// cgroup to the first folds every total into its parent. Parents sort before
+// their children, so a cgroup is complete by the time it is folded.
+void rollUpCgroups(vector<CgroupInfo>& cgroups, const ProcessStore& store)
+{
+    for (auto& cgroup : cgroups) {
+        cgroup.processes = cgroup.totalProcesses = 0;
+        cgroup.totalCPU = 0.0f;
+        cgroup.totalRSS = 0;
+    }
+
+    for (size_t row = 0; row < store.size() && row < store.cgroup.size(); row++) {
+        int index = store.cgroup[row];
+        if (index < 0 || index >= (int)cgroups.size()) continue;
+        CgroupInfo& cgroup = cgroups[index];
+        cgroup.processes++;
+        cgroup.totalProcesses++;
+        cgroup.totalCPU += store.cpu[row];
+        cgroup.totalRSS += store.rss[row];
+    }
+
+    for (size_t i = cgroups.size(); i-- > 0;) {
+        int parent = cgroups[i].parent;
+        if (parent < 0) continue;
+        cgroups[parent].totalProcesses += cgroups[i].totalProcesses;
+        cgroups[parent].totalCPU += cgroups[i].totalCPU;
+        cgroups[parent].totalRSS += cgroups[i].totalRSS;
+    }
+}
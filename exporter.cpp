@@ -0,0 +1,415 @@
+#include "header.h"
+#include <poll.h>
+#include <stdarg.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/eventfd.h>
+
+// Minimal /metrics endpoint in OpenMetrics text format. One thread accepts
+// and answers scrapes one at a time from the latest sampler snapshot, so a
+// scrape never touches /proc. The response is rendered into a buffer that
+// is reused across scrapes and only grows.
+
+static thread exporterThread;
+static int exporterSocket = -1;
+static int exporterWake = -1; // eventfd used to stop the accept loop
+static string exporterPath;   // unix socket path to unlink on stop
+
+// Processes exported per scrape, highest CPU first
+static const size_t exporterTopProcesses = 10;
+
+static void appendf(string& out, const char* fmt, ...)
+{
+    char line[256];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if (n > 0) out.append(line, min((size_t)n, sizeof(line) - 1));
+}
+
+// Label values escaped per the exposition format: backslash, quote, newline
+static void appendLabel(string& out, const string& value)
+{
+    for (char c : value) {
+        if (c == '\\') out += "\\\\";
+        else if (c == '"') out += "\\\"";
+        else if (c == '\n') out += "\\n";
+        else out += c;
+    }
+}
+
+static void appendFamily(string& out, const char* name, const char* type, const char* help)
+{
+    appendf(out, "# TYPE %s %s\n# HELP %s %s\n", name, type, name, help);
+}
+
+void renderMetrics(const SystemSnapshot& snapshot, string& out)
+{
+    static const double ticksPerSecond = (double)sysconf(_SC_CLK_TCK);
+    static const long pageSize = getpagesize();
+    static vector<int> topRows;
+
+    out.clear();
+
+    const CPUStats& cpu = snapshot.cpuStats;
+    const pair<const char*, long long> modes[] = {
+        {"user", cpu.user}, {"nice", cpu.nice}, {"system", cpu.system}, {"idle", cpu.idle},
+        {"iowait", cpu.iowait}, {"irq", cpu.irq}, {"softirq", cpu.softirq}, {"steal", cpu.steal},
+        {"guest", cpu.guest}, {"guest_nice", cpu.guestNice},
+    };
+    appendFamily(out, "monitor_cpu_seconds", "counter", "Time all CPUs spent in each mode.");
+    for (const auto& mode : modes) {
+        appendf(out, "monitor_cpu_seconds_total{mode=\"%s\"} %.2f\n", mode.first, mode.second / ticksPerSecond);
+    }
+
+    appendFamily(out, "monitor_cpu_usage_ratio", "gauge", "Busy fraction of all CPUs over the last sample.");
+    appendf(out, "monitor_cpu_usage_ratio %.4f\n", snapshot.cpuUsage / 100.0);
+    appendFamily(out, "monitor_cpu_core_usage_ratio", "gauge", "Busy fraction of each core over the last sample.");
+    for (size_t i = 0; i < snapshot.coreUsage.size(); i++) {
+        int core = i < snapshot.coreIds.size() ? snapshot.coreIds[i] : (int)i;
+        appendf(out, "monitor_cpu_core_usage_ratio{core=\"%d\"} %.4f\n", core, snapshot.coreUsage[i] / 100.0f);
+    }
+
+    const MemoryInfo& mem = snapshot.memory;
+    appendFamily(out, "monitor_memory_bytes", "gauge", "Physical memory by state.");
+    appendf(out, "monitor_memory_bytes{state=\"total\"} %lu\n", mem.totalRAM);
+    appendf(out, "monitor_memory_bytes{state=\"used\"} %lu\n", mem.usedRAM);
+    appendf(out, "monitor_memory_bytes{state=\"free\"} %lu\n", mem.freeRAM);
+    appendf(out, "monitor_memory_bytes{state=\"available\"} %lu\n", mem.availableRAM);
+    appendf(out, "monitor_memory_bytes{state=\"buffers\"} %lu\n", mem.buffers);
+    appendf(out, "monitor_memory_bytes{state=\"cached\"} %lu\n", mem.cached);
+    appendf(out, "monitor_memory_bytes{state=\"shmem\"} %lu\n", mem.shmem);
+    appendf(out, "monitor_memory_bytes{state=\"slab_reclaimable\"} %lu\n", mem.slabReclaimable);
+    appendf(out, "monitor_memory_bytes{state=\"slab_unreclaimable\"} %lu\n", mem.slabUnreclaimable);
+    appendf(out, "monitor_memory_bytes{state=\"dirty\"} %lu\n", mem.dirty);
+    appendf(out, "monitor_memory_bytes{state=\"writeback\"} %lu\n", mem.writeback);
+    appendFamily(out, "monitor_swap_bytes", "gauge", "Swap space by state.");
+    appendf(out, "monitor_swap_bytes{state=\"total\"} %lu\n", mem.totalSwap);
+    appendf(out, "monitor_swap_bytes{state=\"used\"} %lu\n", mem.usedSwap);
+    appendf(out, "monitor_swap_bytes{state=\"free\"} %lu\n", mem.freeSwap);
+
+    appendFamily(out, "monitor_filesystem_bytes", "gauge", "Filesystem space by state.");
+    for (const auto& disk : *snapshot.filesystems) {
+        const pair<const char*, unsigned long> diskStates[] = {
+            {"total", disk.totalDisk}, {"used", disk.usedDisk}, {"free", disk.freeDisk},
+        };
+        for (const auto& state : diskStates) {
+            out += "monitor_filesystem_bytes{device=\"";
+            appendLabel(out, disk.filesystem);
+            out += "\",mountpoint=\"";
+            appendLabel(out, disk.mountPoint);
+            out += "\",fstype=\"";
+            appendLabel(out, disk.fsType);
+            appendf(out, "\",state=\"%s\"} %lu\n", state.first, state.second);
+        }
+    }
+
+    // Interface counters, one family per field, as node_exporter does
+    struct NetCounter {
+        const char* name;
+        const char* help;
+        long long RX::*rx;
+        long long TX::*tx;
+    };
+    static const NetCounter netCounters[] = {
+        {"monitor_network_receive_bytes", "Bytes received.", &RX::bytes, nullptr},
+        {"monitor_network_receive_packets", "Packets received.", &RX::packets, nullptr},
+        {"monitor_network_receive_errors", "Receive errors.", &RX::errs, nullptr},
+        {"monitor_network_receive_drop", "Received packets dropped.", &RX::drop, nullptr},
+        {"monitor_network_transmit_bytes", "Bytes transmitted.", nullptr, &TX::bytes},
+        {"monitor_network_transmit_packets", "Packets transmitted.", nullptr, &TX::packets},
+        {"monitor_network_transmit_errors", "Transmit errors.", nullptr, &TX::errs},
+        {"monitor_network_transmit_drop", "Transmitted packets dropped.", nullptr, &TX::drop},
+    };
+    for (const auto& counter : netCounters) {
+        appendFamily(out, counter.name, "counter", counter.help);
+        for (const auto& iface : snapshot.interfaces) {
+            long long value = counter.rx ? iface.rx.*counter.rx : iface.tx.*counter.tx;
+            appendf(out, "%s_total{interface=\"", counter.name);
+            appendLabel(out, iface.name);
+            appendf(out, "\"} %lld\n", value);
+        }
+    }
+
+    // Block device counters; sectors are converted to bytes and ticks to seconds
+    struct DiskCounter {
+        const char* name;
+        const char* help;
+        long long DiskIOStats::*field;
+        double scale;
+    };
+    static const DiskCounter diskCounters[] = {
+        {"monitor_disk_reads_completed", "Reads completed.", &DiskIOStats::reads, 1.0},
+        {"monitor_disk_read_bytes", "Bytes read.", &DiskIOStats::readSectors, 512.0},
+        {"monitor_disk_read_time_seconds", "Time spent on reads.", &DiskIOStats::readTicks, 0.001},
+        {"monitor_disk_writes_completed", "Writes completed.", &DiskIOStats::writes, 1.0},
+        {"monitor_disk_written_bytes", "Bytes written.", &DiskIOStats::writeSectors, 512.0},
+        {"monitor_disk_write_time_seconds", "Time spent on writes.", &DiskIOStats::writeTicks, 0.001},
+        {"monitor_disk_io_time_seconds", "Time with I/O in flight.", &DiskIOStats::ioTicks, 0.001},
+    };
+    for (const auto& counter : diskCounters) {
+        appendFamily(out, counter.name, "counter", counter.help);
+        for (const auto& device : snapshot.diskIO) {
+            appendf(out, "%s_total{device=\"", counter.name);
+            appendLabel(out, device.name);
+            appendf(out, "\"} %.15g\n", device.*counter.field * counter.scale);
+        }
+    }
+
+    appendFamily(out, "monitor_pressure_stalled_seconds", "counter", "Time tasks stalled on a resource (PSI).");
+    for (const auto& info : snapshot.pressure) {
+        appendf(out, "monitor_pressure_stalled_seconds_total{resource=\"%s\",kind=\"some\"} %.6f\n",
+                info.resource.c_str(), info.some.total / 1e6);
+        if (info.hasFull) {
+            appendf(out, "monitor_pressure_stalled_seconds_total{resource=\"%s\",kind=\"full\"} %.6f\n",
+                    info.resource.c_str(), info.full.total / 1e6);
+        }
+    }
+
+    appendFamily(out, "monitor_thermal_celsius", "gauge", "Thermal zone temperature.");
+    for (size_t i = 0; i < snapshot.thermal.size(); i++) {
+        appendf(out, "monitor_thermal_celsius{index=\"%zu\",label=\"", i);
+        appendLabel(out, snapshot.thermal[i].label);
+        appendf(out, "\"} %.1f\n", snapshot.thermal[i].temperature);
+    }
+
+    appendFamily(out, "monitor_fan_rpm", "gauge", "Fan speed.");
+    for (size_t i = 0; i < snapshot.fans.size(); i++) {
+        appendf(out, "monitor_fan_rpm{index=\"%zu\",label=\"", i);
+        appendLabel(out, snapshot.fans[i].label);
+        appendf(out, "\"} %d\n", snapshot.fans[i].speed);
+    }
+
+    appendFamily(out, "monitor_tasks", "gauge", "Tasks by state, as counted by top.");
+    for (const auto& count : snapshot.topCounts) {
+        out += "monitor_tasks{state=\"";
+        appendLabel(out, count.first);
+        appendf(out, "\"} %d\n", count.second);
+    }
+
+    // Top processes by CPU, selected over the store's cpu column
+    const ProcessStore& procs = *snapshot.processes;
+    topRows.resize(procs.size());
+    for (size_t i = 0; i < procs.size(); i++) topRows[i] = (int)i;
+    size_t top = min(exporterTopProcesses, topRows.size());
+    partial_sort(topRows.begin(), topRows.begin() + top, topRows.end(),
+                 [&procs](int a, int b) { return procs.cpu[a] > procs.cpu[b]; });
+
+    appendFamily(out, "monitor_process_cpu_ratio", "gauge", "CPU use of the busiest processes, 1 = one core.");
+    for (size_t i = 0; i < top; i++) {
+        int row = topRows[i];
+        appendf(out, "monitor_process_cpu_ratio{pid=\"%d\",name=\"", procs.pid[row]);
+        appendLabel(out, procs.name[row]);
+        appendf(out, "\"} %.4f\n", procs.cpu[row] / 100.0f);
+    }
+    appendFamily(out, "monitor_process_resident_memory_bytes", "gauge", "Resident memory of the busiest processes.");
+    for (size_t i = 0; i < top; i++) {
+        int row = topRows[i];
+        appendf(out, "monitor_process_resident_memory_bytes{pid=\"%d\",name=\"", procs.pid[row]);
+        appendLabel(out, procs.name[row]);
+        appendf(out, "\"} %lld\n", procs.rss[row] * pageSize);
+    }
+
+    out += "# EOF\n";
+}
+
+// Budget for a whole request, reading and writing. Per-call socket timeouts
+// would let a client that trickles a byte at a time hold the one exporter
+// thread for as long as it likes.
+static const int clientDeadlineMs = 2000;
+
+// Wait until the client is ready for `events`; false once the deadline has passed
+static bool waitClient(int fd, short events, chrono::steady_clock::time_point deadline)
+{
+    while (true) {
+        long remaining = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now()).count();
+        if (remaining <= 0) return false;
+
+        struct pollfd pfd = {fd, events, 0};
+        int ready = poll(&pfd, 1, (int)remaining);
+        if (ready > 0) return true;
+        if (ready == 0 || errno != EINTR) return false;
+    }
+}
+
+static bool writeAll(int fd, const char* data, size_t len, chrono::steady_clock::time_point deadline)
+{
+    while (len > 0) {
+        if (!waitClient(fd, POLLOUT, deadline)) return false;
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+        if (n <= 0) return false;
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+static void serveClient(int client, string& body)
+{
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(clientDeadlineMs);
+    char request[2048];
+    size_t len = 0;
+
+    // Only the request line matters; read until the end of the headers
+    while (len < sizeof(request) - 1) {
+        if (!waitClient(client, POLLIN, deadline)) return; // too slow, drop it
+        ssize_t n = recv(client, request + len, sizeof(request) - 1 - len, MSG_DONTWAIT);
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+        if (n <= 0) break;
+        len += n;
+        request[len] = '\0';
+        if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n")) break;
+    }
+    request[len] = '\0';
+
+    char header[256];
+    const char* status = "200 OK";
+    const char* contentType = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+    if (strncmp(request, "GET ", 4) != 0) {
+        status = "405 Method Not Allowed";
+    } else if (strncmp(request + 4, "/metrics ", 9) != 0 && strncmp(request + 4, "/metrics?", 9) != 0) {
+        status = "404 Not Found";
+    }
+
+    if (strcmp(status, "200 OK") == 0) {
+        renderMetrics(*getLatestSnapshot(), body);
+    } else {
+        body.assign(status);
+        body += '\n';
+        contentType = "text/plain; charset=utf-8";
+    }
+
+    int headerLen = snprintf(header, sizeof(header),
+                             "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+                             status, contentType, body.size());
+    if (writeAll(client, header, headerLen, deadline)) {
+        writeAll(client, body.data(), body.size(), deadline);
+    }
+}
+
+// Address is "PORT", "IPV4:PORT" (default host 127.0.0.1) or "unix:/path"
+static int openListener(const string& address)
+{
+    if (address.compare(0, 5, "unix:") == 0) {
+        string path = address.substr(5);
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+            errno = EINVAL;
+            return -1;
+        }
+        strcpy(addr.sun_path, path.c_str());
+
+        // Only a stale socket is replaced; a typo must not delete a regular file,
+        // and a socket someone still accepts on belongs to another exporter
+        struct stat existing;
+        if (lstat(path.c_str(), &existing) == 0) {
+            if (!S_ISSOCK(existing.st_mode)) {
+                errno = EEXIST;
+                return -1;
+            }
+            int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            bool inUse = probe >= 0 && connect(probe, (struct sockaddr*)&addr, sizeof(addr)) == 0;
+            if (probe >= 0) ::close(probe);
+            if (inUse) {
+                errno = EADDRINUSE;
+                return -1;
+            }
+            unlink(path.c_str());
+        }
+
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 16) != 0) {
+            ::close(fd);
+            return -1;
+        }
+        exporterPath = path;
+        return fd;
+    }
+
+    string host = "127.0.0.1";
+    string port = address;
+    size_t colon = address.rfind(':');
+    if (colon != string::npos) {
+        host = address.substr(0, colon);
+        port = address.substr(colon + 1);
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)atoi(port.c_str()));
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1 || addr.sin_port == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 16) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool startExporter(const string& address)
+{
+    if (exporterThread.joinable()) return true;
+
+    exporterSocket = openListener(address);
+    if (exporterSocket < 0) {
+        fprintf(stderr, "Metrics exporter: cannot listen on %s: %s\n", address.c_str(), strerror(errno));
+        return false;
+    }
+    exporterWake = eventfd(0, EFD_CLOEXEC);
+
+    exporterThread = thread([]() {
+        string body;
+        body.reserve(64 * 1024);
+
+        while (true) {
+            struct pollfd fds[2] = {{exporterSocket, POLLIN, 0}, {exporterWake, POLLIN, 0}};
+            if (poll(fds, 2, -1) < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            if (fds[1].revents) break;
+            if (!(fds[0].revents & POLLIN)) continue;
+
+            int client = accept4(exporterSocket, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client < 0) continue;
+
+            // A stalled client holds up the next scrape for clientDeadlineMs at most
+            serveClient(client, body);
+            ::close(client);
+        }
+    });
+    return true;
+}
+
+void stopExporter()
+{
+    if (!exporterThread.joinable()) return;
+
+    uint64_t one = 1;
+    ssize_t written = write(exporterWake, &one, sizeof(one));
+    (void)written;
+    exporterThread.join();
+
+    ::close(exporterSocket);
+    ::close(exporterWake);
+    exporterSocket = -1;
+    exporterWake = -1;
+    if (!exporterPath.empty()) {
+        unlink(exporterPath.c_str());
+        exporterPath.clear();
+    }
+}
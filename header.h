@@ -17,6 +17,8 @@
 // for the name of the computer and the logged in user
 #include <unistd.h>
 #include <limits.h>
+#include <fcntl.h>
+#include <string.h>
 // this is for us to get the cpu information
 // mostly in unix system
 // not sure if it will work in windows
@@ -26,6 +28,8 @@
 #include <sys/types.h>
 #include <sys/sysinfo.h>
 #include <sys/statvfs.h>
+#include <sys/resource.h>
+#include <poll.h>
 // for time and date
 #include <ctime>
 // ifconfig ip addresses
@@ -33,16 +37,63 @@
 #include <ifaddrs.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+// process lifecycle events from the kernel proc connector
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/connector.h>
+#include <linux/cn_proc.h>
+#include <linux/rtnetlink.h>
 #include <map>
+#include <unordered_map>
 #include <string>
 #include <sstream>
 #include <algorithm>
 #include <netdb.h>
+#include <set>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <functional>
 
 
 using namespace std;
 
+// Hand-written decimal scanner for /proc text, no locale or allocation.
+// Returns the position just past the digits.
+static inline const char* scanNumber(const char* p, const char* end, long long& value)
+{
+    bool negative = p < end && *p == '-';
+    if (negative) p++;
+
+    long long v = 0;
+    while (p < end && (unsigned)(*p - '0') < 10) {
+        v = v * 10 + (*p - '0');
+        p++;
+    }
+
+    value = negative ? -v : v;
+    return p;
+}
+
+// Growth of a kernel counter between two reads, computed in 64 bits. Drivers
+// that still keep 32-bit counters wrap at 2^32; any other drop means the
+// counter was reset (interface re-created) and the interval reports nothing.
+static inline uint64_t counterDelta(long long previous, long long current)
+{
+    uint64_t prev = (uint64_t)previous;
+    uint64_t cur = (uint64_t)current;
+    if (cur >= prev) return cur - prev;
+
+    if (prev <= UINT32_MAX) {
+        uint64_t wrapped = cur + (UINT32_MAX - prev) + 1;
+        // A wrap only ever skips a little of the counter's range
+        if (wrapped < (1ULL << 31)) return wrapped;
+    }
+    return 0;
+}
+
 struct CPUStats
 {
     long long int user;
@@ -57,6 +108,16 @@ struct CPUStats
     long long int guestNice;
 };
 
+// Per-core jiffy counters from the cpuN rows of /proc/stat, one array per
+// field so the delta loop runs over contiguous memory
+struct CoreStats {
+    vector<int> ids;         // N of each cpuN row; offline CPUs have no row
+    vector<long long> busy;  // user + nice + system + irq + softirq + steal
+    vector<long long> total; // busy + idle + iowait
+
+    size_t size() const { return busy.size(); }
+};
+
 // processes `stat`
 struct Proc
 {
@@ -67,6 +128,7 @@ struct Proc
     long long int rss;
     long long int utime;
     long long int stime;
+    long long int starttime; // clock ticks after boot, tells a reused PID apart
 };
 
 struct IP4
@@ -110,43 +172,317 @@ string getUsername();
 string getHostname();
 CPUStats getCPUStats();
 double getCPUUsage();
+double cpuUsageBetween(const CPUStats& prev, const CPUStats& current);
+bool readCPUStats(CPUStats& total, CoreStats& cores);
+void computeCoreUsage(const CoreStats& prev, const CoreStats& current, vector<float>& usage);
 map<char, int> getProcessCountByState();
 int getTotalTaskCount();
 map<string, int> getTopStyleProcessCounts();
+map<char, int> emptyProcessStateCounts();
+map<string, int> summarizeProcessStates(const map<char, int>& stateCounts);
 
 // Memory and processes functions
+// /proc/meminfo in bytes, except the HugePages_ counts
 struct MemoryInfo {
     unsigned long totalRAM;
     unsigned long freeRAM;
-    unsigned long usedRAM;
+    unsigned long usedRAM;      // total - available, as free(1) reports it
     unsigned long totalSwap;
     unsigned long freeSwap;
     unsigned long usedSwap;
+
+    unsigned long availableRAM;
+    unsigned long buffers;
+    unsigned long cached;       // page cache, excluding swap cache
+    unsigned long swapCached;
+    unsigned long active;
+    unsigned long inactive;
+    unsigned long shmem;        // tmpfs and shared memory, counted inside cached
+    unsigned long slab;
+    unsigned long slabReclaimable;
+    unsigned long slabUnreclaimable;
+    unsigned long dirty;
+    unsigned long writeback;
+    unsigned long anonPages;
+    unsigned long mapped;
+    unsigned long kernelStack;
+    unsigned long pageTables;
+    unsigned long commitLimit;
+    unsigned long committed;    // Committed_AS
+    unsigned long anonHugePages;
+    unsigned long hugePagesTotal;
+    unsigned long hugePagesFree;
+    unsigned long hugePageSize;
 };
 
 struct DiskInfo {
     unsigned long totalDisk;
     unsigned long freeDisk;
     unsigned long usedDisk;
-    string filesystem;
+    string filesystem; // device
+    string mountPoint;
+    string fsType;
+};
+
+// Filtered copy of /proc/self/mountinfo: one entry per real filesystem, bind
+// mounts and pseudo filesystems dropped. The file is only re-parsed after
+// poll() flags it, which the kernel does on every mount and unmount.
+struct MountTable {
+    struct Mount {
+        string device;
+        string mountPoint;
+        string fsType;
+    };
+
+    int fd = -1;
+    bool stale = true;
+    vector<Mount> mounts;
+
+    ~MountTable();
+
+    bool open();
+    void close();
+    bool active() const { return fd >= 0; }
+    void refresh(); // re-parse if the mount table changed since the last call
+};
+
+string unescapeMountField(const char* p, const char* end);
+
+// Result of one /proc walk, shared by the process table and the task overview
+struct ProcessScan {
+    vector<Proc> processes;
+    map<char, int> stateCounts;
+    map<string, int> topCounts;
+
+    // Process churn since the previous scan, only known with ProcEventListener
+    bool eventDriven = false;
+    unsigned long forks = 0;
+    unsigned long exits = 0;
+};
+
+// Optional kernel proc connector subscription (NETLINK_CONNECTOR with
+// PROC_EVENT_FORK/EXEC/EXIT). Keeps the PID set current between scans so
+// readdir on /proc is only needed to resynchronize. Needs CAP_NET_ADMIN.
+struct ProcEventListener {
+    int sock = -1;
+    bool synced = false; // pids matches /proc; false until the first readdir or after lost events
+    set<int> pids;
+    unsigned long forks = 0;
+    unsigned long execs = 0;
+
+    ~ProcEventListener();
+
+    bool open();
+    void close();
+    bool active() const { return sock >= 0; }
+    void drain();
+};
+
+// Open /proc/PID/stat descriptors kept across refreshes. A cached PID is
+// re-read with one pread() instead of building a path and open/read/close.
+struct ProcFdCache {
+    struct Entry {
+        int fd;
+        unsigned long generation;
+    };
+
+    map<int, Entry> entries;
+    size_t budget = 0;
+    unsigned long generation = 0;
+
+    // 0 derives the budget from RLIMIT_NOFILE
+    explicit ProcFdCache(size_t requestedBudget = 0);
+    ~ProcFdCache();
+    ProcFdCache(const ProcFdCache&) = delete;
+    ProcFdCache& operator=(const ProcFdCache&) = delete;
+
+    void beginScan();
+    ssize_t readStat(int pid, char* buf, size_t size);
+    void endScan();
+    void evict(int pid);
 };
 
 MemoryInfo getMemoryInfo();
-DiskInfo getDiskInfo();
+vector<DiskInfo> getFilesystemUsage(MountTable& table);
+
+// Block device activity from /proc/diskstats, whole devices only. The kernel
+// counts sectors of 512 bytes whatever the device's block size.
+struct DiskIOStats {
+    string name;
+    long long reads;        // completed
+    long long readSectors;
+    long long readTicks;    // ms spent on reads
+    long long writes;
+    long long writeSectors;
+    long long writeTicks;
+    long long ioTicks;      // ms with at least one request in flight
+
+    // Per second over the last disk I/O sampling interval
+    double readOps = 0.0;
+    double writeOps = 0.0;
+    double readBytes = 0.0;
+    double writeBytes = 0.0;
+    double await = 0.0;     // average ms per completed request
+    double util = 0.0;      // % of the interval the device was busy
+};
+
+vector<DiskIOStats> getDiskIOStats();
+void computeDiskIORates(vector<DiskIOStats>& current, const vector<DiskIOStats>& previous, double elapsed);
+ProcessScan scanProcesses(ProcFdCache* cache = nullptr, ProcEventListener* events = nullptr);
 vector<Proc> getProcessList();
+ssize_t readProcFile(const char* path, char* buf, size_t size);
+bool parseProcStat(const char* buf, size_t len, Proc& proc);
 double getProcessCPUUsage(const Proc& proc);
-double getProcessMemoryUsage(const Proc& proc);
-char getCurrentProcessState(int pid);
+
+// Per-process CPU usage from two utime+stime samples, diffed against the
+// system-wide jiffies elapsed in between (same scale as top: 100% = one core)
+struct ProcessCPUSampler {
+    // utime+stime of each PID at the previous sample, with its starttime so a
+    // reused PID is not diffed against the process that had it before
+    struct Ticks {
+        long long starttime;
+        long long ticks;
+    };
+    map<int, Ticks> prevTicks;
+    long long prevTotalJiffies = 0;
+    long numCores = 1;
+
+    map<int, float> update(const vector<Proc>& processes, const CPUStats& cpu);
+};
+
+// Struct-of-arrays process table: row i of every column is the same process.
+// Sorting and filtering only touch the columns they compare.
+struct ProcessStore {
+    vector<int> pid;
+    vector<string> name;
+    vector<char> state;
+    vector<float> cpu;
+    vector<long long> rss; // pages
+    vector<long long> starttime; // clock ticks after boot, tells a reused PID apart
+    vector<float> mem;     // MEM%, filled by computeProcessMemoryUsage
+    vector<double> stateChangedAt; // sampler time of the last state change, -1 if never seen changing
+    vector<int> cgroup;    // index into SystemSnapshot::cgroups, -1 if unknown
+
+    size_t size() const { return pid.size(); }
+};
+
+ProcessStore buildProcessStore(const vector<Proc>& processes, const map<int, float>& cpuUsage);
+void computeProcessMemoryUsage(ProcessStore& store, unsigned long totalRAM);
+void carryProcessStateChanges(ProcessStore& store, const ProcessStore& previous, double now);
+vector<pair<size_t, char>> readProcessStateChanges(const ProcessStore& store, ProcFdCache& cache);
+void applyProcessStateChanges(ProcessStore& store, const vector<pair<size_t, char>>& changes, double now);
+
+// One cgroup v2 directory. Counters are cumulative and -1 when the file is
+// missing (controller not enabled for this cgroup, or the root cgroup).
+struct CgroupInfo {
+    string path;            // relative to the cgroup2 mount, "/" for the root
+    int parent = -1;        // index into the same list, always before this entry
+    bool populated = false; // processes in this cgroup or below (cgroup.events)
+
+    long long usageUsec = -1;     // cpu.stat
+    long long userUsec = -1;
+    long long systemUsec = -1;
+    long long throttledUsec = -1;
+    long long memoryCurrent = -1; // bytes
+    long long memoryAnon = -1;    // memory.stat
+    long long memoryFile = -1;
+    long long ioReadBytes = -1;   // io.stat, summed over devices
+    long long ioWriteBytes = -1;
+
+    // Per second over the last cgroup sampling interval
+    double cpu = 0.0;             // % of one core
+    double ioReadRate = 0.0;
+    double ioWriteRate = 0.0;
+
+    // Member processes, filled by rollUpCgroups. The totals include every descendant.
+    int processes = 0;
+    int totalProcesses = 0;
+    float totalCPU = 0.0f;        // summed process CPU%
+    long long totalRSS = 0;       // pages
+};
+
+// The cgroup v2 hierarchy, kept current through inotify: directories are
+// watched for subgroups being created or removed, and each cgroup.events for
+// populated changes, so only new subtrees are ever walked. Without inotify (or
+// out of watches) every refresh re-walks the whole tree.
+struct CgroupTree {
+    struct Node {
+        bool populated = false;
+    };
+
+    string root;                  // cgroup2 mount point, empty without one
+    int fd = -1;                  // inotify
+    bool stale = true;            // re-walk everything on the next refresh
+    map<string, Node> nodes;      // sorted, so a parent always precedes its children
+    unordered_map<int, string> watches;       // directory watch -> cgroup path
+    unordered_map<int, string> eventsWatches; // cgroup.events watch -> cgroup path
+
+    unsigned long scans = 0;
+
+    // PID -> cgroup path from /proc/PID/cgroup, see assignProcesses for when it is re-read
+    struct CachedCgroup {
+        long long starttime;
+        string path;
+    };
+    unordered_map<int, CachedCgroup> pidCgroups;
+
+    ~CgroupTree();
+
+    bool open();
+    void close();
+    bool active() const { return fd >= 0; }
+    void refresh(); // apply queued inotify events
+    vector<CgroupInfo> collect();
+    // Fill store.cgroup from the cached PID -> cgroup mapping
+    void assignProcesses(const vector<Proc>& processes, const vector<CgroupInfo>& cgroups, ProcessStore& store);
+
+    void addSubtree(const string& path);
+    void removeSubtree(const string& path);
+};
+
+void computeCgroupRates(vector<CgroupInfo>& current, const vector<CgroupInfo>& previous, double elapsed);
+void rollUpCgroups(vector<CgroupInfo>& cgroups, const ProcessStore& store);
 
 // Network functions
+
+// Per-second rates over the last network sampling interval
+struct NetworkRates {
+    double rxBytes = 0.0;
+    double rxPackets = 0.0;
+    double rxErrs = 0.0;
+    double rxDrop = 0.0;
+    double txBytes = 0.0;
+    double txPackets = 0.0;
+    double txErrs = 0.0;
+    double txDrop = 0.0;
+};
+
 struct NetworkInterface {
     string name;
     string ip;
     RX rx;
     TX tx;
+    NetworkRates rates;
+};
+
+// IPv4 address per interface from getifaddrs, kept between samples and only
+// re-read after an rtnetlink link or address notification. Without the
+// netlink socket every lookup re-reads the addresses.
+struct NetworkAddressCache {
+    int sock = -1;
+    bool stale = true;
+    map<string, string> addresses;
+
+    ~NetworkAddressCache();
+
+    bool open();
+    void close();
+    bool active() const { return sock >= 0; }
+    void refresh(); // drain notifications, re-read the addresses if anything changed
 };
 
-vector<NetworkInterface> getNetworkInterfaces();
+vector<NetworkInterface> getNetworkInterfaces(NetworkAddressCache* addresses = nullptr);
+void computeNetworkRates(vector<NetworkInterface>& current, const vector<NetworkInterface>& previous, double elapsed);
 
 // Thermal and fan functions
 struct ThermalInfo {
@@ -162,10 +498,318 @@ struct FanInfo {
 vector<ThermalInfo> getThermalInfo();
 vector<FanInfo> getFanInfo();
 
+// Pressure Stall Information from /proc/pressure/{cpu,memory,io} (Linux 4.20+).
+// avg* are the percentages of time tasks were stalled over 10s/60s/300s.
+struct PressureLine {
+    double avg10 = 0.0;
+    double avg60 = 0.0;
+    double avg300 = 0.0;
+    unsigned long long total = 0; // microseconds stalled since boot
+};
+
+struct PressureInfo {
+    string resource;
+    bool hasFull = false; // no "full" line for cpu before Linux 5.13
+    PressureLine some;    // at least one task stalled
+    PressureLine full;    // every non-idle task stalled at once
+};
+
+vector<PressureInfo> getPressureInfo();
+
+// PSI triggers: "some <stall> <window>" is written to each pressure file and
+// the kernel raises POLLPRI when tasks stall for longer than that within the
+// window. A watcher thread polls the trigger descriptors and calls onStall,
+// so a stall is seen at once while an idle system costs nothing.
+class PressureTriggers {
+public:
+    ~PressureTriggers();
+
+    bool open(unsigned stallUs, unsigned windowUs, function<void()> onStall);
+    void close();
+    bool active() const { return !fds.empty(); }
+    unsigned long events() const { return eventCount.load(); }
+
+private:
+    vector<int> fds;
+    int wakeFd = -1;
+    thread watcher;
+    atomic<unsigned long> eventCount{0};
+};
+
+// Sampling engine: a collector thread publishes immutable snapshots and the
+// UI only ever renders the latest one
+struct SystemSnapshot {
+    unsigned long sequence = 0;
+    double timestamp = 0.0; // seconds since the sampler started
+
+    string osName;
+    string username;
+    string hostname;
+    string cpuModel;
+
+    CPUStats cpuStats = {0};   // cumulative jiffies from the aggregate cpu row
+    double cpuUsage = 0.0;
+    vector<float> coreUsage;   // per-core CPU%, one entry per online CPU
+    vector<int> coreIds;       // CPU number of each coreUsage entry
+    double cpuSampledAt = 0.0; // when cpuUsage/coreUsage were last refreshed
+    MemoryInfo memory = {0};
+    DiskInfo disk = {0};           // root filesystem
+    // The large, rarely-changing parts are shared between snapshots until a
+    // collector replaces them, so a tick that skips them does not copy them
+    // every mounted filesystem, root first
+    shared_ptr<const vector<DiskInfo>> filesystems = make_shared<vector<DiskInfo>>();
+    vector<DiskIOStats> diskIO;
+    double diskIOSampledAt = 0.0;
+
+    shared_ptr<const ProcessStore> processes = make_shared<ProcessStore>();
+    map<char, int> processStates;
+    map<string, int> topCounts;
+    bool processEventsActive = false;
+    unsigned long processForks = 0; // since the previous process refresh
+    unsigned long processExits = 0;
+
+    vector<NetworkInterface> interfaces;
+    double networkSampledAt = 0.0;
+    vector<ThermalInfo> thermal;
+    vector<FanInfo> fans;
+    double sensorsSampledAt = 0.0;
+
+    // refreshed with the process table
+    shared_ptr<const vector<CgroupInfo>> cgroups = make_shared<vector<CgroupInfo>>();
+    double cgroupsSampledAt = 0.0;
+
+    vector<PressureInfo> pressure;
+    double pressureSampledAt = 0.0;
+    bool pressureTriggersActive = false;
+    unsigned long pressureStalls = 0; // trigger events since the sampler started
+};
+
+// Collection intervals in seconds, each collector runs on its own schedule
+struct SamplerConfig {
+    double cpuInterval = 1.0;
+    double memoryInterval = 1.0;
+    double diskInterval = 1.0;
+    double diskIOInterval = 1.0;
+    double processInterval = 3.0; // matches top's default refresh rate
+    double stateInterval = 1.0;   // State column only, re-read between full process scans
+    double networkInterval = 1.0;
+    double sensorInterval = 1.0;
+    double pressureInterval = 1.0;
+    double staticInterval = 60.0;
+
+    // Open /proc/PID/stat descriptors kept between scans, 0 = derive from RLIMIT_NOFILE
+    size_t procFdBudget = 0;
+
+    // Track new/exited processes through the proc connector when permitted
+    bool useProcEvents = true;
+
+    // Re-read pressure as soon as a PSI trigger fires (stall of pressureStallUs
+    // within pressureWindowUs), when the kernel accepts the trigger
+    bool usePressureTriggers = true;
+    unsigned pressureStallUs = 100000;
+    unsigned pressureWindowUs = 1000000;
+
+    // Called on the sampler thread after each new snapshot is published, so an
+    // idle UI can sleep until there is something new to draw
+    function<void()> onSnapshot;
+
+    // Append every snapshot to this binary log when set (recorder.cpp)
+    string recordPath;
+};
+
+void startSampler(const SamplerConfig& config = SamplerConfig());
+void stopSampler();
+shared_ptr<const SystemSnapshot> getLatestSnapshot();
+// Replaces the latest snapshot without a sampler, e.g. when replaying a recording
+void publishSnapshot(shared_ptr<const SystemSnapshot> snapshot);
+
+// Binary snapshot log: keyframes plus zigzag-varint deltas against the
+// previous snapshot, with a keyframe index at the end (recorder.cpp)
+const uint64_t recordKeyframeInterval = 60;
+
+class SnapshotRecorder {
+public:
+    ~SnapshotRecorder();
+
+    bool open(const string& path);
+    void append(const shared_ptr<const SystemSnapshot>& snapshot);
+    void close(); // writes the index and footer
+    bool active() const { return file != nullptr; }
+
+private:
+    struct IndexEntry {
+        int64_t timeMs;
+        uint64_t offset;
+        uint64_t record;
+    };
+
+    FILE* file = nullptr;
+    uint64_t offset = 0;
+    uint64_t records = 0;
+    long long lastTimeMs = 0;
+    vector<IndexEntry> keyframes;
+    shared_ptr<const SystemSnapshot> previous; // delta base
+    vector<uint8_t> frame;
+    vector<uint8_t> payload;
+};
+
+// Read side of a recording, mmap'd. Seeking binary-searches the keyframe
+// index in place and decodes forward to the requested time.
+class SnapshotReplay {
+public:
+    SnapshotReplay() = default;
+    ~SnapshotReplay();
+    SnapshotReplay(const SnapshotReplay&) = delete;
+    SnapshotReplay& operator=(const SnapshotReplay&) = delete;
+
+    bool open(const string& path);
+    shared_ptr<const SystemSnapshot> seek(double time); // sampler clock, seconds
+    shared_ptr<const SystemSnapshot> current() const { return currentSnapshot; }
+
+    double startTime() const;
+    double endTime() const;
+    uint64_t recordCount() const { return records; }
+    int64_t wallClockStart() const { return wallClockStartMs; } // unix ms at sampler time 0
+
+private:
+    struct IndexEntry {
+        int64_t timeMs;
+        uint64_t offset;
+        uint64_t record;
+    };
+
+    IndexEntry keyframe(size_t i) const;
+    bool decodeNext(bool fromKeyframe);
+    long long peekTime() const;
+
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    int64_t wallClockStartMs = 0;
+    const uint8_t* index = nullptr; // in the mapping, or rebuiltIndex for an unfinished log
+    vector<uint8_t> rebuiltIndex;
+    uint64_t keyframeCount = 0;
+    uint64_t records = 0;
+    int64_t lastTimeMs = 0;
+
+    shared_ptr<SystemSnapshot> currentSnapshot;
+    uint64_t currentRecord = 0;
+    size_t currentKeyframe = 0;
+    size_t nextOffset = 0;
+};
+
+// Collectors only, printing one snapshot line per interval (headless.cpp)
+int runHeadless(int argc, char** argv);
+
+// OpenMetrics /metrics endpoint over the latest snapshot (exporter.cpp).
+// Address is "PORT", "IPV4:PORT" or "unix:/path"; TCP defaults to 127.0.0.1.
+void renderMetrics(const SystemSnapshot& snapshot, string& out);
+bool startExporter(const string& address);
+void stopExporter();
+
+// Fixed-capacity history ring, one producer and one consumer. push() is
+// wait-free and O(1): one slot write plus a release store of the counter.
+// Slots live in one array in write order modulo N, so ImGui::PlotLines can
+// draw it in place with data(), size() and offset() as values_offset.
+// A reader that falls a full lap behind may see a slot already overwritten.
+template <typename T, size_t N>
+class MetricRing {
+public:
+    MetricRing() = default;
+
+    // Copying is for setup on the owning thread only (e.g. vector::resize)
+    MetricRing(const MetricRing& other) { *this = other; }
+    MetricRing& operator=(const MetricRing& other)
+    {
+        copy(other.slots, other.slots + N, slots);
+        written.store(other.written.load(memory_order_acquire), memory_order_release);
+        return *this;
+    }
+
+    void push(const T& value)
+    {
+        size_t w = written.load(memory_order_relaxed);
+        slots[w % N] = value;
+        written.store(w + 1, memory_order_release);
+    }
+
+    static constexpr size_t capacity() { return N; }
+    size_t size() const { return min(written.load(memory_order_acquire), N); }
+    bool empty() const { return written.load(memory_order_acquire) == 0; }
+    size_t total() const { return written.load(memory_order_acquire); } // pushes ever made
+
+    // Contiguous view: the oldest sample is at data()[offset()]
+    const T* data() const { return slots; }
+    int offset() const
+    {
+        size_t w = written.load(memory_order_acquire);
+        return w < N ? 0 : (int)(w % N);
+    }
+
+    // i = 0 is the oldest sample still kept
+    const T& at(size_t i) const
+    {
+        size_t w = written.load(memory_order_acquire);
+        size_t oldest = w < N ? 0 : w % N;
+        return slots[(oldest + i) % N];
+    }
+    const T& latest() const { return at(size() - 1); }
+
+    // Producer side only, with no reader active
+    void clear() { written.store(0, memory_order_release); }
+
+private:
+    T slots[N] = {};
+    atomic<size_t> written{0};
+};
+
+// One history point: the samples that fell into [time, time + tier width)
+struct HistoryBucket {
+    double time;
+    float min;
+    float max;
+    float avg;
+};
+
+// Multi-resolution history for one metric. Every sample is rolled into a
+// 1s, a 10s and a 1min bucket; each tier keeps a fixed number of buckets,
+// so 24 hours of history cost the same memory as the first minute.
+class TieredHistory {
+public:
+    static const int tierCount = 3;
+    static const size_t tierPoints = 1440;
+    static const double tierSeconds[tierCount];
+
+    void push(double time, float value);
+
+    bool empty() const { return !open[0].count && tiers[0].empty(); }
+    float latest() const { return lastValue; }
+    double latestTime() const { return lastTime; }
+
+    // Finest tier that still holds `since`, falling back to the coarsest
+    int pickTier(double since) const;
+
+    // Buckets newer than `since`, oldest first, including the one still
+    // filling. Neighbours are merged so out never exceeds maxPoints.
+    void query(double since, int maxPoints, vector<HistoryBucket>& out) const;
+
+private:
+    struct Accumulator {
+        double start = 0.0;
+        float min = 0.0f;
+        float max = 0.0f;
+        double sum = 0.0;
+        int count = 0;
+    };
+
+    MetricRing<HistoryBucket, tierPoints> tiers[tierCount];
+    Accumulator open[tierCount];
+    float lastValue = 0.0f;
+    double lastTime = 0.0;
+};
+
 // UI Enhancement functions
 void setupEnhancedStyle();
 void drawSectionHeader(const char* icon, const char* title, ImVec4 color);
 void drawInfoCard(const char* label, const char* value, ImVec4 labelColor);
-float GetCPUUsage(int pid);
 
 #endif
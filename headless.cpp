@@ -0,0 +1,152 @@
+#include "header.h"
+#include <signal.h>
+
+// Headless collector: runs the sampler without SDL or OpenGL and prints one
+// line per interval. Built into the GUI (monitor --headless) and as the
+// standalone monitor-headless target (make headless).
+//
+// Line format, space-separated key=value pairs, sizes in bytes:
+//   t=<s> cpu=<%> cores=<%,...> mem=<used>/<total> swap=<used>/<total>
+//   disk=<used>/<total> (root filesystem) tasks=<total> running=<n> <iface>=<rx>/<tx>...
+//   temp=<C,...> fan=<rpm,...>
+
+static volatile sig_atomic_t headlessStop = 0;
+
+static void onStopSignal(int)
+{
+    headlessStop = 1;
+}
+
+static void printSnapshot(const SystemSnapshot& snapshot, FILE* out)
+{
+    auto count = [&snapshot](const char* key) {
+        auto it = snapshot.topCounts.find(key);
+        return it != snapshot.topCounts.end() ? it->second : 0;
+    };
+
+    fprintf(out, "t=%.3f cpu=%.1f cores=", snapshot.timestamp, snapshot.cpuUsage);
+    for (size_t i = 0; i < snapshot.coreUsage.size(); i++) {
+        fprintf(out, i ? ",%.1f" : "%.1f", snapshot.coreUsage[i]);
+    }
+
+    fprintf(out, " mem=%lu/%lu swap=%lu/%lu disk=%lu/%lu tasks=%d running=%d",
+            snapshot.memory.usedRAM, snapshot.memory.totalRAM,
+            snapshot.memory.usedSwap, snapshot.memory.totalSwap,
+            snapshot.disk.usedDisk, snapshot.disk.totalDisk,
+            count("total"), count("running"));
+
+    for (const auto& iface : snapshot.interfaces) {
+        fprintf(out, " %s=%lld/%lld", iface.name.c_str(), iface.rx.bytes, iface.tx.bytes);
+    }
+
+    if (!snapshot.thermal.empty()) {
+        fprintf(out, " temp=");
+        for (size_t i = 0; i < snapshot.thermal.size(); i++) {
+            fprintf(out, i ? ",%.1f" : "%.1f", snapshot.thermal[i].temperature);
+        }
+    }
+    if (!snapshot.fans.empty()) {
+        fprintf(out, " fan=");
+        for (size_t i = 0; i < snapshot.fans.size(); i++) {
+            fprintf(out, i ? ",%d" : "%d", snapshot.fans[i].speed);
+        }
+    }
+
+    fputc('\n', out);
+    fflush(out);
+}
+
+static void printHeadlessUsage(const char* argv0)
+{
+    fprintf(stderr, "Usage: %s [--headless] [--interval SECONDS] [--count N] [--metrics ADDRESS] [--record FILE]\n", argv0);
+}
+
+int runHeadless(int argc, char** argv)
+{
+    double interval = 1.0;
+    long count = -1; // lines to print, -1 = until SIGINT/SIGTERM
+    const char* metricsAddress = nullptr;
+    const char* recordPath = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            continue;
+        } else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+            interval = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            count = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+            metricsAddress = argv[++i];
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else {
+            printHeadlessUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (interval <= 0.0) {
+        printHeadlessUsage(argv[0]);
+        return 1;
+    }
+
+    // Every collector runs once per output line
+    SamplerConfig config;
+    config.cpuInterval = interval;
+    config.memoryInterval = interval;
+    config.diskInterval = interval;
+    config.diskIOInterval = interval;
+    config.processInterval = interval;
+    config.stateInterval = interval;
+    config.networkInterval = interval;
+    config.sensorInterval = interval;
+    config.pressureInterval = interval;
+    if (recordPath) config.recordPath = recordPath;
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = onStopSignal;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    // The sampler announces each publish; every new snapshot becomes one line
+    mutex publishMutex;
+    condition_variable published;
+    unsigned long publishCount = 0;
+    config.onSnapshot = [&]() {
+        lock_guard<mutex> lock(publishMutex);
+        publishCount++;
+        published.notify_one();
+    };
+
+    startSampler(config);
+    if (metricsAddress && !startExporter(metricsAddress)) {
+        stopSampler();
+        return 1;
+    }
+
+    unsigned long printed = 0;
+    while (!headlessStop && count != 0) {
+        {
+            // Signal handlers cannot notify, so wake up now and then to check the flag
+            unique_lock<mutex> lock(publishMutex);
+            if (!published.wait_for(lock, chrono::milliseconds(200), [&] { return publishCount != printed; })) {
+                continue;
+            }
+            printed = publishCount;
+        }
+
+        printSnapshot(*getLatestSnapshot(), stdout);
+        if (count > 0) count--;
+    }
+
+    stopExporter();
+    stopSampler();
+    return 0;
+}
+
+#ifdef HEADLESS_MAIN
+int main(int argc, char** argv)
+{
+    return runHeadless(argc, argv);
+}
+#endif
@@ -0,0 +1,106 @@
+#include "header.h"
+
+const double TieredHistory::tierSeconds[TieredHistory::tierCount] = {1.0, 10.0, 60.0};
+
+static HistoryBucket closeBucket(double start, float lo, float hi, double sum, int count)
+{
+    HistoryBucket bucket;
+    bucket.time = start;
+    bucket.min = lo;
+    bucket.max = hi;
+    bucket.avg = (float)(sum / count);
+    return bucket;
+}
+
+void TieredHistory::push(double time, float value)
+{
+    // A clock that steps back (a replay seek) starts the history over
+    if (time < lastTime) {
+        for (int tier = 0; tier < tierCount; tier++) {
+            tiers[tier].clear();
+            open[tier].count = 0;
+        }
+    }
+
+    for (int tier = 0; tier < tierCount; tier++) {
+        Accumulator& acc = open[tier];
+        double start = floor(time / tierSeconds[tier]) * tierSeconds[tier];
+
+        // A sample past the open bucket closes it into the tier's ring
+        if (acc.count && start != acc.start) {
+            tiers[tier].push(closeBucket(acc.start, acc.min, acc.max, acc.sum, acc.count));
+            acc.count = 0;
+        }
+
+        if (acc.count == 0) {
+            acc.start = start;
+            acc.min = value;
+            acc.max = value;
+            acc.sum = 0.0;
+        }
+        acc.min = min(acc.min, value);
+        acc.max = max(acc.max, value);
+        acc.sum += value;
+        acc.count++;
+    }
+
+    lastValue = value;
+    lastTime = time;
+}
+
+int TieredHistory::pickTier(double since) const
+{
+    for (int tier = 0; tier < tierCount; tier++) {
+        const auto& ring = tiers[tier];
+        // A ring that has not wrapped yet still holds everything pushed so far
+        if (ring.total() < ring.capacity() || ring.at(0).time <= since) {
+            return tier;
+        }
+    }
+    return tierCount - 1;
+}
+
+void TieredHistory::query(double since, int maxPoints, vector<HistoryBucket>& out) const
+{
+    out.clear();
+    if (empty() || maxPoints <= 0) return;
+
+    int tier = pickTier(since);
+    const auto& ring = tiers[tier];
+    const Accumulator& acc = open[tier];
+
+    // Bucket times only grow, so the first bucket in range is a binary search away
+    size_t lo = 0;
+    size_t hi = ring.size();
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (ring.at(mid).time + tierSeconds[tier] <= since) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    size_t available = ring.size() - lo + (acc.count ? 1 : 0);
+    size_t group = (available + maxPoints - 1) / maxPoints;
+    auto bucketAt = [&](size_t i) {
+        return i + lo < ring.size() ? ring.at(i + lo)
+                                    : closeBucket(acc.start, acc.min, acc.max, acc.sum, acc.count);
+    };
+
+    // Merge runs of `group` neighbours so there is at most one point per pixel.
+    // The finest tier holding the range never has more than tierPoints buckets.
+    for (size_t i = 0; i < available; i += group) {
+        HistoryBucket merged = bucketAt(i);
+        double sum = merged.avg;
+        size_t n = 1;
+        for (; n < group && i + n < available; n++) {
+            HistoryBucket next = bucketAt(i + n);
+            merged.min = min(merged.min, next.min);
+            merged.max = max(merged.max, next.max);
+            sum += next.avg;
+        }
+        merged.avg = (float)(sum / n);
+        out.push_back(merged);
+    }
+}
@@ -41,6 +41,303 @@ using namespace gl;
 #include IMGUI_IMPL_OPENGL_LOADER_CUSTOM
 #endif
 
+// Per-core usage history for the heatmap, one ring per online CPU
+struct CoreHistory {
+    static const int capacity = 120;
+    vector<MetricRing<float, capacity>> cores;
+    vector<int> ids; // CPU number of each ring
+
+    void push(const vector<float>& usage, const vector<int>& coreIds)
+    {
+        if (usage.size() != cores.size() || coreIds != ids) {
+            cores.assign(usage.size(), MetricRing<float, capacity>());
+            ids = coreIds;
+        }
+        for (size_t core = 0; core < cores.size(); core++) {
+            cores[core].push(usage[core]);
+        }
+    }
+
+    int count() const { return cores.empty() ? 0 : (int)cores[0].size(); }
+};
+
+// Heatmap color: dark blue when idle, through green and yellow, to red at 100%
+static ImU32 heatmapColor(float usage)
+{
+    static const ImVec4 stops[] = {
+        ImVec4(0.13f, 0.20f, 0.35f, 1.00f),
+        ImVec4(0.00f, 0.80f, 0.00f, 1.00f),
+        ImVec4(1.00f, 1.00f, 0.00f, 1.00f),
+        ImVec4(1.00f, 0.00f, 0.00f, 1.00f),
+    };
+
+    float t = max(0.0f, min(usage / 100.0f, 1.0f)) * 3.0f;
+    int i = min((int)t, 2);
+    float f = t - i;
+    const ImVec4& a = stops[i];
+    const ImVec4& b = stops[i + 1];
+    return ImGui::ColorConvertFloat4ToU32(ImVec4(a.x + (b.x - a.x) * f, a.y + (b.y - a.y) * f,
+                                                 a.z + (b.z - a.z) * f, 1.0f));
+}
+
+// Per-core heatmap: cores are rows, samples are columns (newest on the right).
+// Cells go into the window draw list as one reserved batch of rects per row
+// instead of one widget per core. Reserving row by row keeps every batch under
+// the 65536 vertices a 16-bit ImDrawIdx can address; ImGui only starts a new
+// command between reservations.
+static void drawCoreHeatmap(const CoreHistory& history, float maxHeight)
+{
+    int coreCount = (int)history.cores.size();
+    int count = history.count();
+    if (coreCount == 0 || count == 0) return;
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    float width = ImGui::GetContentRegionAvail().x;
+    float rowHeight = max(1.0f, floorf(maxHeight / coreCount));
+    float colWidth = width / CoreHistory::capacity;
+    float firstCol = (float)(CoreHistory::capacity - count);
+
+    for (int core = 0; core < coreCount; core++) {
+        drawList->PrimReserve(count * 6, count * 4);
+        float y = origin.y + core * rowHeight;
+        for (int i = 0; i < count; i++) {
+            float x = origin.x + (firstCol + i) * colWidth;
+            drawList->PrimRect(ImVec2(x, y), ImVec2(x + colWidth, y + rowHeight),
+                               heatmapColor(history.cores[core].at(i)));
+        }
+    }
+
+    ImGui::InvisibleButton("##coreHeatmap", ImVec2(width, rowHeight * coreCount));
+    if (ImGui::IsItemHovered()) {
+        ImVec2 mouse = ImGui::GetIO().MousePos;
+        int core = (int)((mouse.y - origin.y) / rowHeight);
+        int i = (int)((mouse.x - origin.x) / colWidth - firstCol);
+        if (core >= 0 && core < coreCount && i >= 0 && i < count) {
+            int id = core < (int)history.ids.size() ? history.ids[core] : core;
+            ImGui::SetTooltip("CPU%d: %.1f%% (%ds ago)", id, history.cores[core].at(i), count - 1 - i);
+        }
+    }
+}
+
+// Time spans offered by the history graphs
+static const double historyRanges[] = {60.0, 600.0, 3600.0, 6 * 3600.0, 24 * 3600.0};
+static const char* historyRangeLabels[] = {"1 min", "10 min", "1 hour", "6 hours", "24 hours"};
+
+// Resample buckets into `columns` values between start and end, interpolated
+// between bucket times
+static void resampleHistory(const vector<HistoryBucket>& buckets, double start, double end,
+                            int columns, vector<float>& values)
+{
+    values.resize(columns);
+    size_t next = 0;
+    for (int c = 0; c < columns; c++) {
+        double t = start + (end - start) * c / (columns - 1);
+        while (next < buckets.size() && buckets[next].time <= t) next++;
+
+        if (next == 0) {
+            values[c] = buckets.front().avg;
+        } else if (next == buckets.size()) {
+            values[c] = buckets.back().avg;
+        } else {
+            const HistoryBucket& a = buckets[next - 1];
+            const HistoryBucket& b = buckets[next];
+            float f = (float)((t - a.time) / (b.time - a.time));
+            values[c] = a.avg + (b.avg - a.avg) * f;
+        }
+    }
+}
+
+// Plot the `range` seconds before `end` with one column per pixel. Columns
+// are placed by sample time and interpolated between samples, so the graph
+// shows real time whatever the redraw rate. Each sample's min..max is drawn
+// as a faint bar so short spikes survive the downsampling. A `second`
+// history is drawn into the same frame and scale in the histogram color.
+// Returns the top of the scale, which autoscale rounds up to a 1-2-5 step so
+// it stays put while the data moves.
+static float plotHistory(const char* label, const TieredHistory& history, double end, double range,
+                         const char* overlay, float scaleMin, float scaleMax, ImVec2 size,
+                         const TieredHistory* second = nullptr)
+{
+    static vector<HistoryBucket> buckets;
+    static vector<HistoryBucket> secondBuckets;
+    static vector<float> values;
+    static vector<float> secondValues;
+
+    const ImGuiStyle& style = ImGui::GetStyle();
+    float frameWidth = size.x > 0.0f ? size.x : ImGui::CalcItemWidth();
+    float innerWidth = frameWidth - style.FramePadding.x * 2;
+    int columns = max(2, (int)innerWidth);
+    history.query(end - range, columns, buckets);
+    if (buckets.empty()) return scaleMax;
+    secondBuckets.clear();
+    if (second != nullptr) second->query(end - range, columns, secondBuckets);
+
+    // Until the history fills the range it is stretched over the full width
+    double start = max(end - range, buckets.front().time);
+    if (!secondBuckets.empty()) start = min(start, max(end - range, secondBuckets.front().time));
+    if (end <= start) end = start + 1.0;
+
+    float lo = FLT_MAX;
+    float hi = -FLT_MAX;
+    for (const auto& bucket : buckets) {
+        lo = min(lo, bucket.min);
+        hi = max(hi, bucket.max);
+    }
+    for (const auto& bucket : secondBuckets) {
+        lo = min(lo, bucket.min);
+        hi = max(hi, bucket.max);
+    }
+
+    resampleHistory(buckets, start, end, columns, values);
+
+    // FLT_MAX asks for autoscale, same as PlotLines
+    if (scaleMin == FLT_MAX) scaleMin = lo;
+    if (scaleMax == FLT_MAX) {
+        scaleMax = hi;
+        if (hi > 0.0f) {
+            float step = powf(10.0f, floorf(log10f(hi)));
+            scaleMax = hi <= step ? step : hi <= 2 * step ? 2 * step : hi <= 5 * step ? 5 * step : 10 * step;
+        }
+    }
+
+    ImGui::PlotLines(label, values.data(), columns, 0, overlay, scaleMin, scaleMax, size);
+
+    float scale = scaleMax > scaleMin ? 1.0f / (scaleMax - scaleMin) : 0.0f;
+    ImVec2 inner = ImVec2(ImGui::GetItemRectMin().x + style.FramePadding.x,
+                          ImGui::GetItemRectMin().y + style.FramePadding.y);
+    float innerHeight = ImGui::GetItemRectSize().y - style.FramePadding.y * 2;
+    auto toY = [&](float value) {
+        return inner.y + (1.0f - max(0.0f, min((value - scaleMin) * scale, 1.0f))) * innerHeight;
+    };
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    auto drawRanges = [&](const vector<HistoryBucket>& list, ImU32 color) {
+        for (const auto& bucket : list) {
+            if (bucket.max <= bucket.min || bucket.time < start) continue;
+            float x = inner.x + innerWidth * (float)((bucket.time - start) / (end - start));
+            drawList->AddLine(ImVec2(x, toY(bucket.max)), ImVec2(x, toY(bucket.min)), color);
+        }
+    };
+    drawRanges(buckets, ImGui::GetColorU32(ImGuiCol_PlotLines, 0.35f));
+
+    if (!secondBuckets.empty()) {
+        static vector<ImVec2> points;
+        resampleHistory(secondBuckets, start, end, columns, secondValues);
+        points.resize(columns);
+        for (int c = 0; c < columns; c++) {
+            points[c] = ImVec2(inner.x + innerWidth * c / (columns - 1), toY(secondValues[c]));
+        }
+        drawRanges(secondBuckets, ImGui::GetColorU32(ImGuiCol_PlotHistogram, 0.35f));
+        drawList->AddPolyline(points.data(), columns, ImGui::GetColorU32(ImGuiCol_PlotHistogram), 0, 1.0f);
+    }
+    return scaleMax;
+}
+
+// Every graph's history. The main loop feeds it once per new snapshot, also
+// while the window is minimized, so a window that is not drawn loses no samples.
+// One point per real sample, timestamped with the sampler clock; the FPS
+// sliders only pace redraws.
+struct GraphHistories {
+    CoreHistory cores;
+    TieredHistory cpu;
+    vector<TieredHistory> thermal;
+    vector<TieredHistory> fans;
+    map<string, TieredHistory> diskRead;
+    map<string, TieredHistory> diskWrite;
+    map<string, TieredHistory> pressureSome; // avg10
+    map<string, TieredHistory> pressureFull;
+    map<string, TieredHistory> rx;           // bits/s
+    map<string, TieredHistory> tx;
+
+    double lastCPUSample = -1.0;
+    double lastSensorSample = -1.0;
+    double lastDiskIOSample = -1.0;
+    double lastPressureSample = -1.0;
+    double lastNetworkSample = -1.0;
+
+    void ingest(const SystemSnapshot& snapshot);
+};
+
+static GraphHistories histories;
+
+// Drop the histories of keys the latest sample no longer lists, so churning
+// interfaces and devices (veth pairs, loop devices) do not pile up
+template <typename Items, typename KeyOf>
+static void pruneHistories(map<string, TieredHistory>& byKey, const Items& items, KeyOf keyOf)
+{
+    for (auto it = byKey.begin(); it != byKey.end();) {
+        bool present = any_of(items.begin(), items.end(),
+                              [&](const typename Items::value_type& item) { return keyOf(item) == it->first; });
+        it = present ? next(it) : byKey.erase(it);
+    }
+}
+
+// History for a key, or nullptr before its first sample
+static const TieredHistory* findHistory(const map<string, TieredHistory>& byKey, const string& key)
+{
+    auto it = byKey.find(key);
+    return it != byKey.end() ? &it->second : nullptr;
+}
+
+void GraphHistories::ingest(const SystemSnapshot& snapshot)
+{
+    if (snapshot.cpuSampledAt != lastCPUSample) {
+        if (!snapshot.coreUsage.empty()) {
+            cores.push(snapshot.coreUsage, snapshot.coreIds);
+        }
+        cpu.push(snapshot.cpuSampledAt, (float)snapshot.cpuUsage);
+        lastCPUSample = snapshot.cpuSampledAt;
+    }
+
+    if (snapshot.sensorsSampledAt != lastSensorSample) {
+        thermal.resize(snapshot.thermal.size());
+        for (size_t i = 0; i < snapshot.thermal.size(); i++) {
+            thermal[i].push(snapshot.sensorsSampledAt, (float)snapshot.thermal[i].temperature);
+        }
+        fans.resize(snapshot.fans.size());
+        for (size_t i = 0; i < snapshot.fans.size(); i++) {
+            fans[i].push(snapshot.sensorsSampledAt, (float)snapshot.fans[i].speed);
+        }
+        lastSensorSample = snapshot.sensorsSampledAt;
+    }
+
+    if (snapshot.diskIOSampledAt != lastDiskIOSample) {
+        for (const auto& device : snapshot.diskIO) {
+            diskRead[device.name].push(snapshot.diskIOSampledAt, (float)device.readBytes);
+            diskWrite[device.name].push(snapshot.diskIOSampledAt, (float)device.writeBytes);
+        }
+        auto deviceName = [](const DiskIOStats& device) -> const string& { return device.name; };
+        pruneHistories(diskRead, snapshot.diskIO, deviceName);
+        pruneHistories(diskWrite, snapshot.diskIO, deviceName);
+        lastDiskIOSample = snapshot.diskIOSampledAt;
+    }
+
+    if (snapshot.pressureSampledAt != lastPressureSample) {
+        for (const auto& info : snapshot.pressure) {
+            pressureSome[info.resource].push(snapshot.pressureSampledAt, (float)info.some.avg10);
+            if (info.hasFull) {
+                pressureFull[info.resource].push(snapshot.pressureSampledAt, (float)info.full.avg10);
+            }
+        }
+        auto resource = [](const PressureInfo& info) -> const string& { return info.resource; };
+        pruneHistories(pressureSome, snapshot.pressure, resource);
+        pruneHistories(pressureFull, snapshot.pressure, resource);
+        lastPressureSample = snapshot.pressureSampledAt;
+    }
+
+    if (snapshot.networkSampledAt != lastNetworkSample) {
+        for (const auto& iface : snapshot.interfaces) {
+            rx[iface.name].push(snapshot.networkSampledAt, (float)(iface.rates.rxBytes * 8.0));
+            tx[iface.name].push(snapshot.networkSampledAt, (float)(iface.rates.txBytes * 8.0));
+        }
+        auto interfaceName = [](const NetworkInterface& iface) -> const string& { return iface.name; };
+        pruneHistories(rx, snapshot.interfaces, interfaceName);
+        pruneHistories(tx, snapshot.interfaces, interfaceName);
+        lastNetworkSample = snapshot.networkSampledAt;
+    }
+}
+
 // systemWindow, display information for the system monitorization
 void systemWindow(const char *id, ImVec2 size, ImVec2 position)
 {
@@ -48,33 +345,22 @@ void systemWindow(const char *id, ImVec2 size, ImVec2 position)
     ImGui::SetWindowSize(id, size);
     ImGui::SetWindowPos(id, position);
 
-    // Static variables for throttling updates
-    static float lastStaticUpdate = 0;
-    static float lastTaskUpdate = 0;
-    static string cachedOsName = "";
-    static string cachedUsername = "";
-    static string cachedHostname = "";
-    static string cachedCPUinfo = "";
-    static map<char, int> cachedProcessStates;
-    static map<string, int> cachedTopStyleCounts;
+    // Everything shown here comes from the sampler's latest snapshot
+    shared_ptr<const SystemSnapshot> snapshot = getLatestSnapshot();
 
-    float currentTime = ImGui::GetTime();
-
-    // Update static system info only once (or very rarely)
-    if (cachedOsName.empty() || currentTime - lastStaticUpdate > 60.0f) {
-        cachedOsName = getOsName();
-        cachedUsername = getUsername();
-        cachedHostname = getHostname();
-        cachedCPUinfo = CPUinfo();
-        lastStaticUpdate = currentTime;
-    }
+    auto taskCount = [&snapshot](const char* key) {
+        auto it = snapshot->topCounts.find(key);
+        return it != snapshot->topCounts.end() ? it->second : 0;
+    };
 
-    // Update task counts every 3 seconds (matches top's default refresh rate)
-    if (currentTime - lastTaskUpdate > 3.0f) {
-        cachedProcessStates = getProcessCountByState();
-        cachedTopStyleCounts = getTopStyleProcessCounts();
-        lastTaskUpdate = currentTime;
-    }
+    CoreHistory& coreHistory = histories.cores;
+    TieredHistory& cpuHistory = histories.cpu;
+    vector<TieredHistory>& thermalHistory = histories.thermal;
+    vector<TieredHistory>& fanHistory = histories.fans;
+    const map<string, TieredHistory>& diskReadHistory = histories.diskRead;
+    const map<string, TieredHistory>& diskWriteHistory = histories.diskWrite;
+    const map<string, TieredHistory>& pressureSomeHistory = histories.pressureSome;
+    const map<string, TieredHistory>& pressureFullHistory = histories.pressureFull;
 
     // System Information Section
     if (ImGui::CollapsingHeader("System Information", ImGuiTreeNodeFlags_DefaultOpen)) {
@@ -85,22 +371,22 @@ void systemWindow(const char *id, ImVec2 size, ImVec2 position)
         // OS Information with icon
         ImGui::TextColored(ImVec4(0.11f, 0.64f, 0.92f, 1.00f), "OS:");
         ImGui::SameLine(80);
-        ImGui::Text("%s", cachedOsName.c_str());
+        ImGui::Text("%s", snapshot->osName.c_str());
 
         // User Information with icon
         ImGui::TextColored(ImVec4(0.11f, 0.64f, 0.92f, 1.00f), "User:");
         ImGui::SameLine(80);
-        ImGui::Text("%s", cachedUsername.c_str());
+        ImGui::Text("%s", snapshot->username.c_str());
 
         // Hostname with icon
         ImGui::TextColored(ImVec4(0.11f, 0.64f, 0.92f, 1.00f), "Host:");
         ImGui::SameLine(80);
-        ImGui::Text("%s", cachedHostname.c_str());
+        ImGui::Text("%s", snapshot->hostname.c_str());
 
         // CPU Information with icon
         ImGui::TextColored(ImVec4(0.11f, 0.64f, 0.92f, 1.00f), "CPU:");
         ImGui::SameLine(80);
-        ImGui::TextWrapped("%s", cachedCPUinfo.c_str());
+        ImGui::TextWrapped("%s", snapshot->cpuModel.c_str());
 
         ImGui::EndChild();
         ImGui::PopStyleColor();
@@ -114,23 +400,30 @@ void systemWindow(const char *id, ImVec2 size, ImVec2 position)
             // Display the same statistics as Tasks Overview but in detailed format
             ImGui::TextColored(ImVec4(0.11f, 0.64f, 0.92f, 1.00f), "Total Tasks:");
             ImGui::SameLine(120);
-            ImGui::Text("%d", cachedTopStyleCounts["total"]);
+            ImGui::Text("%d", taskCount("total"));
 
             ImGui::TextColored(ImVec4(0.00f, 1.00f, 0.00f, 1.00f), "Running:");
             ImGui::SameLine(120);
-            ImGui::Text("%d", cachedTopStyleCounts["running"]);
+            ImGui::Text("%d", taskCount("running"));
 
             ImGui::TextColored(ImVec4(0.90f, 0.70f, 0.00f, 1.00f), "Sleeping:");
             ImGui::SameLine(120);
-            ImGui::Text("%d", cachedTopStyleCounts["sleeping"]);
+            ImGui::Text("%d", taskCount("sleeping"));
 
             ImGui::TextColored(ImVec4(1.00f, 0.60f, 0.00f, 1.00f), "Stopped:");
             ImGui::SameLine(120);
-            ImGui::Text("%d", cachedTopStyleCounts["stopped"]);
+            ImGui::Text("%d", taskCount("stopped"));
 
             ImGui::TextColored(ImVec4(1.00f, 0.00f, 0.00f, 1.00f), "Zombie:");
             ImGui::SameLine(120);
-            ImGui::Text("%d", cachedTopStyleCounts["zombie"]);
+            ImGui::Text("%d", taskCount("zombie"));
+
+            // Short-lived processes only show up here, they never last until a scan
+            if (snapshot->processEventsActive) {
+                ImGui::TextColored(ImVec4(0.11f, 0.64f, 0.92f, 1.00f), "Forks/Exits:");
+                ImGui::SameLine(120);
+                ImGui::Text("%lu / %lu", snapshot->processForks, snapshot->processExits);
+            }
 
             ImGui::Unindent();
         }
@@ -140,31 +433,20 @@ void systemWindow(const char *id, ImVec2 size, ImVec2 position)
     if (ImGui::BeginTabBar("SystemMonitoringTabs")) {
         // CPU Tab
         if (ImGui::BeginTabItem("CPU")) {
-            static vector<float> cpuHistory;
+            static int range = 0;
             static bool animate = true;
             static float fps = 60.0f;
             static float yScale = 100.0f;
-            static double cachedCPU = 0.0;
-            static float lastCPUUpdate = 0;
             static float lastGraphUpdate = 0;
+            static double graphEnd = 0.0;
 
             float currentTime = ImGui::GetTime();
+            double cachedCPU = snapshot->cpuUsage;
 
-            // Update CPU data every 1 second for responsive monitoring
-            if (currentTime - lastCPUUpdate > 1.0f) {
-                cachedCPU = getCPUUsage();
-                lastCPUUpdate = currentTime;
-            }
-
-            // Update graph based on FPS setting (only if animation is enabled)
+            // Scroll the graph at the FPS setting (only if animation is enabled)
             float updateInterval = 1.0f / fps; // Convert FPS to update interval
             if (animate && (currentTime - lastGraphUpdate > updateInterval)) {
-                cpuHistory.push_back((float)cachedCPU);
-
-                // Keep only last 100 values
-                if (cpuHistory.size() > 100) {
-                    cpuHistory.erase(cpuHistory.begin());
-                }
+                graphEnd = snapshot->timestamp;
                 lastGraphUpdate = currentTime;
             }
 
@@ -199,6 +481,7 @@ void systemWindow(const char *id, ImVec2 size, ImVec2 position)
             ImGui::Checkbox("Animate", &animate);
             ImGui::SameLine();
             ImGui::SliderFloat("FPS", &fps, 1.0f, 120.0f);
+            ImGui::Combo("Range", &range, historyRangeLabels, IM_ARRAYSIZE(historyRangeLabels));
             ImGui::SliderFloat("Y-Scale", &yScale, 50.0f, 200.0f);
 
             ImGui::Spacing();
@@ -207,54 +490,40 @@ void systemWindow(const char *id, ImVec2 size, ImVec2 position)
 
             // Enhanced CPU usage graph
             if (!cpuHistory.empty()) {
-                ImGui::PlotLines("", cpuHistory.data(), cpuHistory.size(),
-                               0, nullptr, 0.0f, yScale, ImVec2(0, 120));
+                plotHistory("", cpuHistory, graphEnd, historyRanges[range], nullptr, 0.0f, yScale, ImVec2(0, 120));
             }
 
+            ImGui::Spacing();
+            ImGui::TextColored(ImVec4(0.90f, 0.70f, 0.00f, 1.00f), "Per-Core Usage (%d cores):", (int)coreHistory.cores.size());
+            ImGui::Separator();
+            drawCoreHeatmap(coreHistory, 160.0f);
+
             ImGui::EndTabItem();
         }
 
         // Thermal Tab
         if (ImGui::BeginTabItem("Thermal")) {
-            static vector<vector<float>> thermalHistory;
+            static int range = 0;
             static bool animate = true;
             static float fps = 60.0f;
             static float yScale = 100.0f;
-            static vector<ThermalInfo> cachedThermalInfo;
-            static float lastThermalUpdate = 0;
             static float lastGraphUpdate = 0;
+            static double graphEnd = 0.0;
 
             float currentTime = ImGui::GetTime();
+            const vector<ThermalInfo>& cachedThermalInfo = snapshot->thermal;
 
-            // Update thermal data every 1 second for responsive monitoring
-            if (currentTime - lastThermalUpdate > 1.0f) {
-                cachedThermalInfo = getThermalInfo();
-                lastThermalUpdate = currentTime;
-            }
-
-            // Initialize thermal history if needed
-            if (thermalHistory.size() != cachedThermalInfo.size()) {
-                thermalHistory.resize(cachedThermalInfo.size());
-            }
-
-            // Update graph based on FPS setting (only if animation is enabled)
+            // Scroll the graphs at the FPS setting (only if animation is enabled)
             float updateInterval = 1.0f / fps; // Convert FPS to update interval
             if (animate && (currentTime - lastGraphUpdate > updateInterval)) {
-                // Update thermal history
-                for (size_t i = 0; i < cachedThermalInfo.size(); i++) {
-                    thermalHistory[i].push_back((float)cachedThermalInfo[i].temperature);
-
-                    // Keep only last 100 values
-                    if (thermalHistory[i].size() > 100) {
-                        thermalHistory[i].erase(thermalHistory[i].begin());
-                    }
-                }
+                graphEnd = snapshot->timestamp;
                 lastGraphUpdate = currentTime;
             }
 
             ImGui::Checkbox("Animate", &animate);
             ImGui::SameLine();
             ImGui::SliderFloat("FPS", &fps, 1.0f, 120.0f);
+            ImGui::Combo("Range", &range, historyRangeLabels, IM_ARRAYSIZE(historyRangeLabels));
             ImGui::SliderFloat("Y-Scale", &yScale, 50.0f, 200.0f);
 
             if (cachedThermalInfo.empty()) {
@@ -302,10 +571,8 @@ void systemWindow(const char *id, ImVec2 size, ImVec2 position)
 
                     // Plot thermal history
                     if (!thermalHistory[i].empty()) {
-                        ImGui::PlotLines(("History: " + thermal.label).c_str(),
-                                       thermalHistory[i].data(),
-                                       thermalHistory[i].size(),
-                                       0, nullptr, 0.0f, yScale, ImVec2(0, 80));
+                        plotHistory(("History: " + thermal.label).c_str(), thermalHistory[i], graphEnd,
+                                    historyRanges[range], nullptr, 0.0f, yScale, ImVec2(0, 80));
                     }
 
                     ImGui::Spacing();
@@ -317,45 +584,27 @@ void systemWindow(const char *id, ImVec2 size, ImVec2 position)
 
         // Fan Tab
         if (ImGui::BeginTabItem("Fan")) {
-            static vector<vector<float>> fanHistory;
+            static int range = 0;
             static bool animate = true;
             static float fps = 60.0f;
             static float yScale = 5000.0f; // Higher scale for RPM
-            static vector<FanInfo> cachedFanInfo;
-            static float lastFanUpdate = 0;
             static float lastGraphUpdate = 0;
+            static double graphEnd = 0.0;
 
             float currentTime = ImGui::GetTime();
+            const vector<FanInfo>& cachedFanInfo = snapshot->fans;
 
-            // Update fan data every 1 second for responsive monitoring
-            if (currentTime - lastFanUpdate > 1.0f) {
-                cachedFanInfo = getFanInfo();
-                lastFanUpdate = currentTime;
-            }
-
-            // Initialize fan history if needed
-            if (fanHistory.size() != cachedFanInfo.size()) {
-                fanHistory.resize(cachedFanInfo.size());
-            }
-
-            // Update graph based on FPS setting (only if animation is enabled)
+            // Scroll the graphs at the FPS setting (only if animation is enabled)
             float updateInterval = 1.0f / fps; // Convert FPS to update interval
             if (animate && (currentTime - lastGraphUpdate > updateInterval)) {
-                // Update fan history
-                for (size_t i = 0; i < cachedFanInfo.size(); i++) {
-                    fanHistory[i].push_back((float)cachedFanInfo[i].speed);
-
-                    // Keep only last 100 values
-                    if (fanHistory[i].size() > 100) {
-                        fanHistory[i].erase(fanHistory[i].begin());
-                    }
-                }
+                graphEnd = snapshot->timestamp;
                 lastGraphUpdate = currentTime;
             }
 
             ImGui::Checkbox("Animate", &animate);
             ImGui::SameLine();
             ImGui::SliderFloat("FPS", &fps, 1.0f, 120.0f);
+            ImGui::Combo("Range", &range, historyRangeLabels, IM_ARRAYSIZE(historyRangeLabels));
             ImGui::SliderFloat("Y-Scale", &yScale, 1000.0f, 10000.0f);
 
             if (cachedFanInfo.empty()) {
@@ -372,11 +621,170 @@ void systemWindow(const char *id, ImVec2 size, ImVec2 position)
 
                     // Plot fan history
                     if (!fanHistory[i].empty()) {
-                        ImGui::PlotLines(("RPM " + fan.label).c_str(),
-                                       fanHistory[i].data(),
-                                       fanHistory[i].size(),
-                                       0, nullptr, 0.0f, yScale, ImVec2(0, 80));
+                        plotHistory(("RPM " + fan.label).c_str(), fanHistory[i], graphEnd,
+                                    historyRanges[range], nullptr, 0.0f, yScale, ImVec2(0, 80));
+                    }
+                }
+            }
+
+            ImGui::EndTabItem();
+        }
+
+        // Disk I/O Tab
+        if (ImGui::BeginTabItem("Disk I/O")) {
+            static int range = 0;
+            static bool animate = true;
+            static float fps = 60.0f;
+            static float lastGraphUpdate = 0;
+            static double graphEnd = 0.0;
+
+            float currentTime = ImGui::GetTime();
+            const vector<DiskIOStats>& devices = snapshot->diskIO;
+
+            // Scroll the graphs at the FPS setting (only if animation is enabled)
+            float updateInterval = 1.0f / fps; // Convert FPS to update interval
+            if (animate && (currentTime - lastGraphUpdate > updateInterval)) {
+                graphEnd = snapshot->timestamp;
+                lastGraphUpdate = currentTime;
+            }
+
+            ImGui::Checkbox("Animate", &animate);
+            ImGui::SameLine();
+            ImGui::SliderFloat("FPS", &fps, 1.0f, 120.0f);
+            ImGui::Combo("Range", &range, historyRangeLabels, IM_ARRAYSIZE(historyRangeLabels));
+
+            auto formatRate = [](double bytes) -> string {
+                const char* units[] = {"B/s", "KB/s", "MB/s", "GB/s"};
+                int unit = 0;
+                while (bytes >= 1024.0 && unit < 3) {
+                    bytes /= 1024.0;
+                    unit++;
+                }
+                char buffer[32];
+                snprintf(buffer, sizeof(buffer), "%.1f %s", bytes, units[unit]);
+                return string(buffer);
+            };
+
+            if (devices.empty()) {
+                ImGui::Text("No block devices found");
+            } else {
+                if (ImGui::BeginTable("DiskIOTable", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+                    ImGui::TableSetupColumn("Device");
+                    ImGui::TableSetupColumn("Read/s");
+                    ImGui::TableSetupColumn("Write/s");
+                    ImGui::TableSetupColumn("r IOPS");
+                    ImGui::TableSetupColumn("w IOPS");
+                    ImGui::TableSetupColumn("Await");
+                    ImGui::TableSetupColumn("Util", ImGuiTableColumnFlags_WidthStretch);
+                    ImGui::TableHeadersRow();
+
+                    for (const auto& device : devices) {
+                        ImGui::TableNextRow();
+                        ImGui::TableSetColumnIndex(0); ImGui::Text("%s", device.name.c_str());
+                        ImGui::TableSetColumnIndex(1); ImGui::Text("%s", formatRate(device.readBytes).c_str());
+                        ImGui::TableSetColumnIndex(2); ImGui::Text("%s", formatRate(device.writeBytes).c_str());
+                        ImGui::TableSetColumnIndex(3); ImGui::Text("%.1f", device.readOps);
+                        ImGui::TableSetColumnIndex(4); ImGui::Text("%.1f", device.writeOps);
+                        ImGui::TableSetColumnIndex(5); ImGui::Text("%.2f ms", device.await);
+                        ImGui::TableSetColumnIndex(6);
+                        char util[16];
+                        snprintf(util, sizeof(util), "%.1f%%", device.util);
+                        ImGui::ProgressBar((float)device.util / 100.0f, ImVec2(-1, 0), util);
                     }
+
+                    ImGui::EndTable();
+                }
+
+                // One graph per device: reads as the line, writes in the histogram color
+                for (const auto& device : devices) {
+                    const TieredHistory* reads = findHistory(diskReadHistory, device.name);
+                    if (!reads || reads->empty()) continue;
+
+                    string overlay = "R " + formatRate(device.readBytes) + "  W " + formatRate(device.writeBytes);
+                    ImGui::Text("%s", device.name.c_str());
+                    float scale = plotHistory(("##io" + device.name).c_str(), *reads, graphEnd, historyRanges[range],
+                                              overlay.c_str(), 0.0f, FLT_MAX, ImVec2(0, 80),
+                                              findHistory(diskWriteHistory, device.name));
+                    ImGui::Text("Scale: 0 - %s", formatRate(scale).c_str());
+                }
+            }
+
+            ImGui::EndTabItem();
+        }
+
+        // Pressure Tab
+        if (ImGui::BeginTabItem("Pressure")) {
+            static int range = 0;
+            static bool animate = true;
+            static float fps = 60.0f;
+            static float yScale = 100.0f;
+            static float lastGraphUpdate = 0;
+            static double graphEnd = 0.0;
+
+            float currentTime = ImGui::GetTime();
+            const vector<PressureInfo>& pressure = snapshot->pressure;
+
+            // Scroll the graphs at the FPS setting (only if animation is enabled)
+            float updateInterval = 1.0f / fps; // Convert FPS to update interval
+            if (animate && (currentTime - lastGraphUpdate > updateInterval)) {
+                graphEnd = snapshot->timestamp;
+                lastGraphUpdate = currentTime;
+            }
+
+            ImGui::Checkbox("Animate", &animate);
+            ImGui::SameLine();
+            ImGui::SliderFloat("FPS", &fps, 1.0f, 120.0f);
+            ImGui::Combo("Range", &range, historyRangeLabels, IM_ARRAYSIZE(historyRangeLabels));
+            ImGui::SliderFloat("Y-Scale", &yScale, 1.0f, 100.0f, "%.0f%%");
+
+            if (pressure.empty()) {
+                ImGui::Text("Pressure stall information not available (Linux 4.20+ with PSI enabled)");
+            } else {
+                if (snapshot->pressureTriggersActive) {
+                    ImGui::TextColored(ImVec4(0, 1, 0, 1), "Stall triggers active");
+                    ImGui::SameLine();
+                    ImGui::Text("(%lu stall events)", snapshot->pressureStalls);
+                } else {
+                    ImGui::TextColored(ImVec4(1.00f, 0.70f, 0.00f, 1.00f), "Stall triggers unavailable, polling");
+                }
+
+                if (ImGui::BeginTable("PressureTable", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+                    ImGui::TableSetupColumn("Resource");
+                    ImGui::TableSetupColumn("some avg10");
+                    ImGui::TableSetupColumn("some avg60");
+                    ImGui::TableSetupColumn("some avg300");
+                    ImGui::TableSetupColumn("full avg10");
+                    ImGui::TableSetupColumn("full avg60");
+                    ImGui::TableSetupColumn("full avg300");
+                    ImGui::TableHeadersRow();
+
+                    for (const auto& info : pressure) {
+                        ImGui::TableNextRow();
+                        ImGui::TableSetColumnIndex(0); ImGui::Text("%s", info.resource.c_str());
+                        ImGui::TableSetColumnIndex(1); ImGui::Text("%.2f%%", info.some.avg10);
+                        ImGui::TableSetColumnIndex(2); ImGui::Text("%.2f%%", info.some.avg60);
+                        ImGui::TableSetColumnIndex(3); ImGui::Text("%.2f%%", info.some.avg300);
+                        if (info.hasFull) {
+                            ImGui::TableSetColumnIndex(4); ImGui::Text("%.2f%%", info.full.avg10);
+                            ImGui::TableSetColumnIndex(5); ImGui::Text("%.2f%%", info.full.avg60);
+                            ImGui::TableSetColumnIndex(6); ImGui::Text("%.2f%%", info.full.avg300);
+                        }
+                    }
+
+                    ImGui::EndTable();
+                }
+
+                // some avg10 as the line, full avg10 in the histogram color
+                for (const auto& info : pressure) {
+                    const TieredHistory* some = findHistory(pressureSomeHistory, info.resource);
+                    if (!some || some->empty()) continue;
+
+                    char overlay[64];
+                    snprintf(overlay, sizeof(overlay), "some %.2f%%  full %.2f%%", info.some.avg10, info.full.avg10);
+                    ImGui::Text("%s", info.resource.c_str());
+                    plotHistory(("##psi" + info.resource).c_str(), *some, graphEnd, historyRanges[range], overlay,
+                                0.0f, yScale, ImVec2(0, 80),
+                                info.hasFull ? findHistory(pressureFullHistory, info.resource) : nullptr);
                 }
             }
 
@@ -389,6 +797,263 @@ void systemWindow(const char *id, ImVec2 size, ImVec2 position)
     ImGui::End();
 }
 
+// Process table sort key, copied out of ImGuiTableSortSpecs which only lives for one frame
+struct ProcessSortKey {
+    int column;
+    bool descending;
+};
+
+// Ordering of two store rows under the active sort keys, ties broken by PID
+static bool processRowLess(const ProcessStore& store, const vector<ProcessSortKey>& keys, int a, int b)
+{
+    for (const auto& key : keys) {
+        int delta = 0;
+        switch (key.column) {
+        case 0: delta = (store.pid[a] > store.pid[b]) - (store.pid[a] < store.pid[b]); break;
+        case 1: delta = store.name[a].compare(store.name[b]); break;
+        case 2: delta = store.state[a] - store.state[b]; break;
+        case 3: delta = (store.cpu[a] > store.cpu[b]) - (store.cpu[a] < store.cpu[b]); break;
+        case 4: delta = (store.rss[a] > store.rss[b]) - (store.rss[a] < store.rss[b]); break;
+        }
+        if (delta != 0) return key.descending ? delta > 0 : delta < 0;
+    }
+    return store.pid[a] < store.pid[b];
+}
+
+// Case-insensitive match, filter is already lowercase
+static bool processNameMatches(const string& name, const string& filter)
+{
+    return filter.empty() ||
+           search(name.begin(), name.end(), filter.begin(), filter.end(),
+                  [](char a, char b) { return tolower((unsigned char)a) == b; }) != name.end();
+}
+
+// Insertion sort: close to linear when the rows are already almost in order,
+// which is the usual case between two refreshes. Gives up once it has moved
+// rows more than maxMoves times (CPU% or RSS order reshuffles every refresh)
+// and returns false, leaving the rows permuted but complete for a full sort.
+template <typename Less>
+static bool insertionSort(vector<int>& rows, Less less, size_t maxMoves)
+{
+    size_t moves = 0;
+    for (size_t i = 1; i < rows.size(); i++) {
+        int row = rows[i];
+        size_t j = i;
+        while (j > 0 && less(row, rows[j - 1])) {
+            rows[j] = rows[j - 1];
+            j--;
+            moves++;
+        }
+        rows[j] = row;
+        if (moves > maxMoves) return false;
+    }
+    return true;
+}
+
+// Rebuild the displayed rows (indices into the store). PIDs that were already
+// shown keep their previous position so the re-sort only has to move what changed.
+static void refreshProcessRows(const ProcessStore& store, const string& filter,
+                               const vector<ProcessSortKey>& keys, bool fullSort,
+                               vector<int>& rows, vector<int>& rowPids)
+{
+    auto matches = [&store, &filter](int row) { return processNameMatches(store.name[row], filter); };
+
+    vector<int> next;
+    next.reserve(store.size());
+    vector<char> placed(store.size(), 0);
+
+    if (!fullSort) {
+        unordered_map<int, int> rowOfPid;
+        rowOfPid.reserve(store.size());
+        for (int row = 0; row < (int)store.size(); row++) {
+            rowOfPid[store.pid[row]] = row;
+        }
+
+        for (int pid : rowPids) {
+            auto it = rowOfPid.find(pid);
+            if (it != rowOfPid.end() && matches(it->second)) {
+                next.push_back(it->second);
+                placed[it->second] = 1;
+            }
+        }
+    }
+
+    size_t carried = next.size();
+    for (int row = 0; row < (int)store.size(); row++) {
+        if (!placed[row] && matches(row)) {
+            next.push_back(row);
+        }
+    }
+
+    auto less = [&store, &keys](int a, int b) { return processRowLess(store, keys, a, b); };
+
+    // Many new rows (first frame, widened filter) or a heavily reshuffled order
+    // are cheaper to sort from scratch
+    size_t added = next.size() - carried;
+    if (fullSort || added > next.size() / 8 + 16 || !insertionSort(next, less, 4 * next.size())) {
+        stable_sort(next.begin(), next.end(), less);
+    }
+
+    rows.swap(next);
+    rowPids.resize(rows.size());
+    for (size_t i = 0; i < rows.size(); i++) {
+        rowPids[i] = store.pid[rows[i]];
+    }
+}
+
+// Layout of the cgroup tree: visible subgroups and member processes of every
+// cgroup, busiest first. A cgroup is visible when a process in its subtree
+// matches the filter, worked out bottom-up like the rollups.
+struct CgroupTreeRows {
+    vector<vector<int>> children; // cgroup indices
+    vector<vector<int>> members;  // process store rows
+    vector<char> visible;
+
+    // Expanded cgroups by path, so they stay open across refreshes. Only the
+    // root starts open; on hosts with thousands of scopes the rest stay folded.
+    set<string> open = {"/"};
+
+    // The rows currently in view, in draw order, so the table can be clipped
+    // like the process list. Rebuilt with the tree and after a node is toggled.
+    struct Line {
+        int depth;
+        int cgroup;
+        int process; // process store row, -1 for the cgroup itself
+    };
+    vector<Line> lines;
+    bool linesStale = true;
+};
+
+static void buildCgroupTreeRows(const SystemSnapshot& snapshot, const string& filter, CgroupTreeRows& rows)
+{
+    const vector<CgroupInfo>& cgroups = *snapshot.cgroups;
+    const ProcessStore& processes = *snapshot.processes;
+    size_t count = cgroups.size();
+    rows.children.assign(count, vector<int>());
+    rows.members.assign(count, vector<int>());
+    rows.visible.assign(count, filter.empty() ? 1 : 0);
+
+    for (size_t row = 0; row < processes.size() && row < processes.cgroup.size(); row++) {
+        int cgroup = processes.cgroup[row];
+        if (cgroup < 0 || cgroup >= (int)count || !processNameMatches(processes.name[row], filter)) continue;
+        rows.members[cgroup].push_back((int)row);
+        rows.visible[cgroup] = 1;
+    }
+
+    for (size_t i = count; i-- > 0;) {
+        int parent = cgroups[i].parent;
+        if (parent < 0 || !rows.visible[i]) continue;
+        rows.children[parent].push_back((int)i);
+        rows.visible[parent] = 1;
+    }
+
+    for (auto& children : rows.children) {
+        sort(children.begin(), children.end(),
+             [&cgroups](int a, int b) { return cgroups[a].totalCPU > cgroups[b].totalCPU; });
+    }
+    for (auto& members : rows.members) {
+        sort(members.begin(), members.end(),
+             [&processes](int a, int b) { return processes.cpu[a] > processes.cpu[b]; });
+    }
+}
+
+static void addCgroupLines(const vector<CgroupInfo>& cgroups, CgroupTreeRows& rows, int index, int depth)
+{
+    rows.lines.push_back({depth, index, -1});
+    if (!rows.open.count(cgroups[index].path)) return;
+
+    for (int child : rows.children[index]) {
+        addCgroupLines(cgroups, rows, child, depth + 1);
+    }
+    for (int row : rows.members[index]) {
+        rows.lines.push_back({depth + 1, index, row});
+    }
+}
+
+static void flattenCgroupTree(const SystemSnapshot& snapshot, CgroupTreeRows& rows)
+{
+    rows.lines.clear();
+    // Parents come first, so entry 0 is the root of the hierarchy
+    if (!rows.visible.empty() && rows.visible[0]) addCgroupLines(*snapshot.cgroups, rows, 0, 0);
+    rows.linesStale = false;
+}
+
+// One line of the flattened tree: a cgroup with its rolled-up CPU% and MEM%,
+// or one of its member processes. Opening or closing a cgroup marks the lines
+// stale for the next frame.
+static void drawCgroupLine(const SystemSnapshot& snapshot, CgroupTreeRows& rows, const CgroupTreeRows::Line& line)
+{
+    static const long pageSize = getpagesize();
+    const CgroupInfo& cgroup = (*snapshot.cgroups)[line.cgroup];
+    const ProcessStore& processes = *snapshot.processes;
+    unsigned long totalRAM = snapshot.memory.totalRAM;
+    float indent = line.depth * ImGui::GetStyle().IndentSpacing;
+
+    ImGui::TableNextRow();
+    ImGui::TableSetColumnIndex(0);
+    if (indent > 0.0f) ImGui::Indent(indent);
+
+    if (line.process >= 0) {
+        int row = line.process;
+        ImGui::TreeNodeEx((void*)(intptr_t)processes.pid[row],
+                          ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_Bullet | ImGuiTreeNodeFlags_NoTreePushOnOpen |
+                          ImGuiTreeNodeFlags_SpanFullWidth,
+                          "%s", processes.name[row].c_str());
+        if (indent > 0.0f) ImGui::Unindent(indent);
+        ImGui::TableSetColumnIndex(1);
+        ImGui::Text("%d", processes.pid[row]);
+        ImGui::TableSetColumnIndex(2);
+        ImGui::Text("%c", processes.state[row]);
+        ImGui::TableSetColumnIndex(3);
+        ImGui::Text("%.1f", processes.cpu[row]);
+        ImGui::TableSetColumnIndex(4);
+        ImGui::Text("%.1f", processes.mem[row]);
+        return;
+    }
+
+    const char* name = cgroup.path == "/" ? "/" : cgroup.path.c_str() + cgroup.path.rfind('/') + 1;
+    ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_SpanFullWidth | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+    bool leaf = rows.children[line.cgroup].empty() && rows.members[line.cgroup].empty();
+    if (leaf) flags |= ImGuiTreeNodeFlags_Leaf;
+    bool wasOpen = rows.open.count(cgroup.path) != 0;
+    ImGui::SetNextItemOpen(wasOpen, ImGuiCond_Always);
+    bool open = ImGui::TreeNodeEx(cgroup.path.c_str(), flags, "%s", name);
+    if (!leaf && open != wasOpen) {
+        if (open) {
+            rows.open.insert(cgroup.path);
+        } else {
+            rows.open.erase(cgroup.path);
+        }
+        rows.linesStale = true;
+    }
+
+    // Kernel accounting for the whole cgroup, including processes that already exited
+    if (ImGui::IsItemHovered()) {
+        ImGui::BeginTooltip();
+        ImGui::Text("%s", cgroup.path.c_str());
+        if (cgroup.usageUsec >= 0) ImGui::Text("cpu.stat: %.1f%% CPU", cgroup.cpu);
+        if (cgroup.throttledUsec >= 0) ImGui::Text("Throttled: %.1f s", cgroup.throttledUsec / 1e6);
+        if (cgroup.memoryCurrent >= 0) ImGui::Text("Memory: %.1f MB", cgroup.memoryCurrent / 1048576.0);
+        if (cgroup.memoryAnon >= 0) {
+            ImGui::Text("Anon: %.1f MB  File: %.1f MB", cgroup.memoryAnon / 1048576.0, cgroup.memoryFile / 1048576.0);
+        }
+        if (cgroup.ioReadBytes >= 0) {
+            ImGui::Text("I/O: read %.1f KB/s  write %.1f KB/s", cgroup.ioReadRate / 1024.0, cgroup.ioWriteRate / 1024.0);
+        }
+        ImGui::EndTooltip();
+    }
+    if (indent > 0.0f) ImGui::Unindent(indent);
+
+    ImGui::TableSetColumnIndex(1);
+    ImGui::TextDisabled("%d", cgroup.totalProcesses);
+    ImGui::TableSetColumnIndex(2);
+    ImGui::TextDisabled("%s", cgroup.populated ? "" : "empty");
+    ImGui::TableSetColumnIndex(3);
+    ImGui::Text("%.1f", cgroup.totalCPU);
+    ImGui::TableSetColumnIndex(4);
+    ImGui::Text("%.1f", totalRAM ? (double)cgroup.totalRSS * pageSize * 100.0 / totalRAM : 0.0);
+}
+
 // memoryProcessesWindow, display information for the memory and processes information
 void memoryProcessesWindow(const char *id, ImVec2 size, ImVec2 position)
 {
@@ -396,9 +1061,11 @@ void memoryProcessesWindow(const char *id, ImVec2 size, ImVec2 position)
     ImGui::SetWindowSize(id, size);
     ImGui::SetWindowPos(id, position);
 
+    shared_ptr<const SystemSnapshot> snapshot = getLatestSnapshot();
+
     // Memory Usage Section
     if (ImGui::CollapsingHeader("Memory Usage", ImGuiTreeNodeFlags_DefaultOpen)) {
-        MemoryInfo memInfo = getMemoryInfo();
+        const MemoryInfo& memInfo = snapshot->memory;
 
         // Helper function to format bytes with appropriate units
         auto formatBytes = [](unsigned long bytes) -> string {
@@ -417,25 +1084,70 @@ void memoryProcessesWindow(const char *id, ImVec2 size, ImVec2 position)
         };
 
         // Enhanced RAM Usage Display
-        float ramUsage = (float)memInfo.usedRAM / memInfo.totalRAM;
+        float ramUsage = memInfo.totalRAM ? (float)memInfo.usedRAM / memInfo.totalRAM : 0.0f;
 
         ImGui::PushStyleColor(ImGuiCol_ChildBg, ImVec4(0.18f, 0.20f, 0.22f, 1.00f));
-        ImGui::BeginChild("RAMUsageBox", ImVec2(0, 80), true);
+        ImGui::BeginChild("RAMUsageBox", ImVec2(0, 100), true);
 
         ImGui::TextColored(ImVec4(0.11f, 0.64f, 0.92f, 1.00f), "RAM Usage");
         ImGui::Text("%s / %s", formatBytes(memInfo.usedRAM).c_str(), formatBytes(memInfo.totalRAM).c_str());
 
-        // Color-coded progress bar
+        // Color-coded usage, by how much is not reclaimable
         ImVec4 ramColor = ImVec4(0.00f, 1.00f, 0.00f, 1.00f); // Green
         if (ramUsage > 0.7f) ramColor = ImVec4(1.00f, 1.00f, 0.00f, 1.00f); // Yellow
         if (ramUsage > 0.9f) ramColor = ImVec4(1.00f, 0.00f, 0.00f, 1.00f); // Red
 
-        ImGui::PushStyleColor(ImGuiCol_PlotHistogram, ramColor);
-        ImGui::ProgressBar(ramUsage, ImVec2(-1, 0), "");
-        ImGui::PopStyleColor();
+        // Stacked used/buffers/cache/free bar, split the way htop does:
+        // cache = Cached + SReclaimable - Shmem, used = the rest that is not free
+        unsigned long cache = memInfo.cached + memInfo.slabReclaimable;
+        cache = cache > memInfo.shmem ? cache - memInfo.shmem : 0;
+        unsigned long accounted = memInfo.freeRAM + memInfo.buffers + cache;
+        unsigned long used = memInfo.totalRAM > accounted ? memInfo.totalRAM - accounted : 0;
+        struct RAMSegment {
+            const char* label;
+            unsigned long bytes;
+            ImVec4 color;
+        };
+        const RAMSegment segments[] = {
+            {"Used", used, ramColor},
+            {"Buffers", memInfo.buffers, ImVec4(0.11f, 0.64f, 0.92f, 1.00f)},
+            {"Cache", cache, ImVec4(0.90f, 0.70f, 0.00f, 1.00f)},
+            {"Free", memInfo.freeRAM, ImVec4(0.30f, 0.30f, 0.30f, 1.00f)},
+        };
+
+        ImVec2 barMin = ImGui::GetCursorScreenPos();
+        float barWidth = ImGui::GetContentRegionAvail().x;
+        float barHeight = ImGui::GetFrameHeight();
+        ImDrawList* drawList = ImGui::GetWindowDrawList();
+        float x = barMin.x;
+        for (const auto& segment : segments) {
+            float width = memInfo.totalRAM ? barWidth * segment.bytes / memInfo.totalRAM : 0.0f;
+            drawList->AddRectFilled(ImVec2(x, barMin.y), ImVec2(x + width, barMin.y + barHeight),
+                                    ImGui::GetColorU32(segment.color));
+            x += width;
+        }
+        ImGui::Dummy(ImVec2(barWidth, barHeight));
+        if (ImGui::IsItemHovered()) {
+            ImGui::BeginTooltip();
+            ImGui::Text("Shmem: %s", formatBytes(memInfo.shmem).c_str());
+            ImGui::Text("Slab: %s (%s reclaimable)", formatBytes(memInfo.slab).c_str(),
+                        formatBytes(memInfo.slabReclaimable).c_str());
+            ImGui::Text("Dirty: %s  Writeback: %s", formatBytes(memInfo.dirty).c_str(),
+                        formatBytes(memInfo.writeback).c_str());
+            ImGui::Text("Committed: %s / %s", formatBytes(memInfo.committed).c_str(),
+                        formatBytes(memInfo.commitLimit).c_str());
+            if (memInfo.hugePagesTotal > 0) {
+                ImGui::Text("HugePages: %lu free of %lu (%s each)", memInfo.hugePagesFree, memInfo.hugePagesTotal,
+                            formatBytes(memInfo.hugePageSize).c_str());
+            }
+            ImGui::EndTooltip();
+        }
 
-        ImGui::SameLine(0, ImGui::GetStyle().ItemInnerSpacing.x);
-        ImGui::TextColored(ramColor, "%.1f%%", ramUsage * 100.0f);
+        // Legend
+        for (size_t i = 0; i < IM_ARRAYSIZE(segments); i++) {
+            if (i > 0) ImGui::SameLine();
+            ImGui::TextColored(segments[i].color, "%s %s", segments[i].label, formatBytes(segments[i].bytes).c_str());
+        }
 
         ImGui::EndChild();
         ImGui::PopStyleColor();
@@ -466,15 +1178,42 @@ void memoryProcessesWindow(const char *id, ImVec2 size, ImVec2 position)
             ImGui::PopStyleColor();
         }
 
-        // Disk Usage (Used/Size format)
-        DiskInfo diskInfo = getDiskInfo();
-        float diskUsage = (float)diskInfo.usedDisk / diskInfo.totalDisk;
-        ImGui::Text("Disk: %s / %s",
-                   formatBytes(diskInfo.usedDisk).c_str(),
-                   formatBytes(diskInfo.totalDisk).c_str());
-        ImGui::ProgressBar(diskUsage, ImVec2(-1, 0), "");
-        ImGui::SameLine(0, ImGui::GetStyle().ItemInnerSpacing.x);
-        ImGui::Text("%.1f%%", diskUsage * 100.0f);
+        // Disk usage of every mounted filesystem, root first
+        const vector<DiskInfo>& filesystems = *snapshot->filesystems;
+        ImGui::TextColored(ImVec4(0.11f, 0.64f, 0.92f, 1.00f), "Filesystems");
+        if (ImGui::BeginTable("Filesystems", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable)) {
+            ImGui::TableSetupColumn("Mount");
+            ImGui::TableSetupColumn("Device");
+            ImGui::TableSetupColumn("Type");
+            ImGui::TableSetupColumn("Used / Size");
+            ImGui::TableSetupColumn("Usage", ImGuiTableColumnFlags_WidthStretch);
+            ImGui::TableHeadersRow();
+
+            for (const auto& disk : filesystems) {
+                float diskUsage = disk.totalDisk ? (float)disk.usedDisk / disk.totalDisk : 0.0f;
+
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0); ImGui::Text("%s", disk.mountPoint.c_str());
+                ImGui::TableSetColumnIndex(1); ImGui::Text("%s", disk.filesystem.c_str());
+                ImGui::TableSetColumnIndex(2); ImGui::Text("%s", disk.fsType.c_str());
+                ImGui::TableSetColumnIndex(3);
+                ImGui::Text("%s / %s", formatBytes(disk.usedDisk).c_str(), formatBytes(disk.totalDisk).c_str());
+                ImGui::TableSetColumnIndex(4);
+
+                // Color-coded progress bar
+                ImVec4 diskColor = ImVec4(0.00f, 1.00f, 0.00f, 1.00f); // Green
+                if (diskUsage > 0.8f) diskColor = ImVec4(1.00f, 1.00f, 0.00f, 1.00f); // Yellow
+                if (diskUsage > 0.95f) diskColor = ImVec4(1.00f, 0.00f, 0.00f, 1.00f); // Red
+
+                char percent[16];
+                snprintf(percent, sizeof(percent), "%.1f%%", diskUsage * 100.0f);
+                ImGui::PushStyleColor(ImGuiCol_PlotHistogram, diskColor);
+                ImGui::ProgressBar(diskUsage, ImVec2(-1, 0), percent);
+                ImGui::PopStyleColor();
+            }
+
+            ImGui::EndTable();
+        }
     }
 
     // Process Monitor Section
@@ -488,114 +1227,147 @@ void memoryProcessesWindow(const char *id, ImVec2 size, ImVec2 position)
         ImGui::InputText("##filter", filter, sizeof(filter));
         ImGui::PopStyleColor();
 
-        // Get process list
-        static vector<Proc> processes;
-        static float lastUpdate = 0;
-        float currentTime = ImGui::GetTime();
+        // Flat table, or processes grouped under their cgroup v2 hierarchy
+        static int view = 0;
+        ImGui::SameLine();
+        ImGui::RadioButton("List", &view, 0);
+        ImGui::SameLine();
+        ImGui::RadioButton("cgroups", &view, 1);
 
-        // Update process list every 3 seconds (matches top's default refresh rate)
-        if (currentTime - lastUpdate > 3.0f) {
-            processes = getProcessList();
-            lastUpdate = currentTime;
-        }
+        const ProcessStore& processes = *snapshot->processes;
+
+        // Displayed rows as indices into the store, in sorted order. Redone only
+        // when the filter, the sort specs or the snapshot change.
+        static vector<int> filteredRows;
+        static vector<int> filteredPids;
+        static vector<ProcessSortKey> sortKeys;
+        static string lastFilter;
+        static unsigned long lastSequence = 0;
 
-        // Filter processes
-        vector<Proc> filteredProcesses;
         string filterStr = string(filter);
         transform(filterStr.begin(), filterStr.end(), filterStr.begin(), ::tolower);
 
-        for (const auto& proc : processes) {
-            if (filterStr.empty()) {
-                filteredProcesses.push_back(proc);
-            } else {
-                string procName = proc.name;
-                transform(procName.begin(), procName.end(), procName.begin(), ::tolower);
-                if (procName.find(filterStr) != string::npos) {
-                    filteredProcesses.push_back(proc);
+        // cgroup tree or the flat process table
+        if (view == 1) {
+            static CgroupTreeRows treeRows;
+            static string lastTreeFilter;
+            static unsigned long lastTreeSequence = 0;
+            if (snapshot->cgroups->empty()) {
+                ImGui::Text("cgroup v2 hierarchy not available");
+            } else if (ImGui::BeginTable("CgroupTree", 5, ImGuiTableFlags_BordersV | ImGuiTableFlags_BordersOuterH |
+                                         ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+                ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_WidthStretch);
+                ImGui::TableSetupColumn("PID", ImGuiTableColumnFlags_WidthFixed, 80.0f);
+                ImGui::TableSetupColumn("State", ImGuiTableColumnFlags_WidthFixed, 60.0f);
+                ImGui::TableSetupColumn("CPU%", ImGuiTableColumnFlags_WidthFixed, 80.0f);
+                ImGui::TableSetupColumn("MEM%", ImGuiTableColumnFlags_WidthFixed, 80.0f);
+                ImGui::TableSetupScrollFreeze(0, 1);
+                ImGui::TableHeadersRow();
+
+                if (filterStr != lastTreeFilter || snapshot->sequence != lastTreeSequence) {
+                    buildCgroupTreeRows(*snapshot, filterStr, treeRows);
+                    lastTreeFilter = filterStr;
+                    lastTreeSequence = snapshot->sequence;
+                    treeRows.linesStale = true;
                 }
-            }
-        }
+                if (treeRows.linesStale) flattenCgroupTree(*snapshot, treeRows);
 
-        // Process table
-        if (ImGui::BeginTable("ProcessTable", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg |
-                             ImGuiTableFlags_Sortable | ImGuiTableFlags_ScrollY)) {
+                ImGuiListClipper clipper;
+                clipper.Begin((int)treeRows.lines.size());
+                while (clipper.Step()) {
+                    for (int line = clipper.DisplayStart; line < clipper.DisplayEnd; line++) {
+                        drawCgroupLine(*snapshot, treeRows, treeRows.lines[line]);
+                    }
+                }
+
+                ImGui::EndTable();
+            }
+        } else if (ImGui::BeginTable("ProcessTable", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg |
+                             ImGuiTableFlags_Sortable | ImGuiTableFlags_SortMulti | ImGuiTableFlags_ScrollY)) {
             ImGui::TableSetupColumn("PID", ImGuiTableColumnFlags_WidthFixed, 80.0f);
             ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_WidthStretch);
             ImGui::TableSetupColumn("State", ImGuiTableColumnFlags_WidthFixed, 60.0f);
             ImGui::TableSetupColumn("CPU%", ImGuiTableColumnFlags_WidthFixed, 80.0f);
             ImGui::TableSetupColumn("MEM%", ImGuiTableColumnFlags_WidthFixed, 80.0f);
+            ImGui::TableSetupScrollFreeze(0, 1); // keep the header visible while scrolling
             ImGui::TableHeadersRow();
 
-            // Display processes (limit to first 100 for performance)
-            int displayCount = min(100, (int)filteredProcesses.size());
-            for (int i = 0; i < displayCount; i++) {
-                const auto& proc = filteredProcesses[i];
+            bool specsChanged = false;
+            if (ImGuiTableSortSpecs* specs = ImGui::TableGetSortSpecs()) {
+                if (specs->SpecsDirty) {
+                    sortKeys.clear();
+                    for (int n = 0; n < specs->SpecsCount; n++) {
+                        sortKeys.push_back({specs->Specs[n].ColumnIndex,
+                                            specs->Specs[n].SortDirection == ImGuiSortDirection_Descending});
+                    }
+                    specs->SpecsDirty = false;
+                    specsChanged = true;
+                }
+            }
 
-                ImGui::TableNextRow();
+            if (specsChanged || filterStr != lastFilter || snapshot->sequence != lastSequence) {
+                refreshProcessRows(processes, filterStr, sortKeys, specsChanged, filteredRows, filteredPids);
+                lastFilter = filterStr;
+                lastSequence = snapshot->sequence;
+            }
 
-                // Multi-row selection
-                ImGui::TableSetColumnIndex(0);
-                bool isSelected = find(selectedProcesses.begin(), selectedProcesses.end(), proc.pid)
-                                != selectedProcesses.end();
-
-                if (ImGui::Selectable(to_string(proc.pid).c_str(), isSelected,
-                                    ImGuiSelectableFlags_SpanAllColumns)) {
-                    if (ImGui::GetIO().KeyCtrl) {
-                        // Multi-select with Ctrl
-                        if (isSelected) {
-                            selectedProcesses.erase(
-                                remove(selectedProcesses.begin(), selectedProcesses.end(), proc.pid),
-                                selectedProcesses.end());
+            // How long a state change stays highlighted
+            const double stateHighlightSeconds = 2.0;
+
+            // Every process is reachable, but only the rows on screen are submitted
+            ImGuiListClipper clipper;
+            clipper.Begin((int)filteredRows.size());
+            while (clipper.Step()) {
+                for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                    int index = filteredRows[row];
+                    int pid = processes.pid[index];
+
+                    ImGui::TableNextRow();
+
+                    // Multi-row selection
+                    ImGui::TableSetColumnIndex(0);
+                    bool isSelected = find(selectedProcesses.begin(), selectedProcesses.end(), pid)
+                                    != selectedProcesses.end();
+
+                    char pidLabel[16];
+                    snprintf(pidLabel, sizeof(pidLabel), "%d", pid);
+                    if (ImGui::Selectable(pidLabel, isSelected, ImGuiSelectableFlags_SpanAllColumns)) {
+                        if (ImGui::GetIO().KeyCtrl) {
+                            // Multi-select with Ctrl
+                            if (isSelected) {
+                                selectedProcesses.erase(
+                                    remove(selectedProcesses.begin(), selectedProcesses.end(), pid),
+                                    selectedProcesses.end());
+                            } else {
+                                selectedProcesses.push_back(pid);
+                            }
                         } else {
-                            selectedProcesses.push_back(proc.pid);
+                            // Single select
+                            selectedProcesses.clear();
+                            selectedProcesses.push_back(pid);
                         }
-                    } else {
-                        // Single select
-                        selectedProcesses.clear();
-                        selectedProcesses.push_back(proc.pid);
                     }
-                }
-
-                ImGui::TableSetColumnIndex(1);
-                ImGui::Text("%s", proc.name.c_str());
 
-                ImGui::TableSetColumnIndex(2);
-                // Read process state fresh every time (like top does)
-                char currentState = getCurrentProcessState(proc.pid);
-                ImGui::Text("%c", currentState);
+                    ImGui::TableSetColumnIndex(1);
+                    ImGui::Text("%s", processes.name[index].c_str());
 
-                ImGui::TableSetColumnIndex(3);
-                // Async CPU usage calculation
-                static map<int, future<float>> cpuFutures;
-                static map<int, float> cachedCPUUsage;
-
-                float cpuUsage = 0.0f;
-                if (cpuFutures.find(proc.pid) == cpuFutures.end() || 
-                    cpuFutures[proc.pid].wait_for(chrono::seconds(0)) == future_status::ready) {
-                    
-                    // Get result if ready
-                    if (cpuFutures.find(proc.pid) != cpuFutures.end() && 
-                        cpuFutures[proc.pid].wait_for(chrono::seconds(0)) == future_status::ready) {
-                        cachedCPUUsage[proc.pid] = cpuFutures[proc.pid].get();
+                    ImGui::TableSetColumnIndex(2);
+                    // State is refreshed by the sampler; recent changes are highlighted
+                    double changedAt = processes.stateChangedAt[index];
+                    if (changedAt >= 0 && snapshot->timestamp - changedAt < stateHighlightSeconds) {
+                        ImGui::TableSetBgColor(ImGuiTableBgTarget_CellBg, IM_COL32(230, 180, 0, 90));
+                        ImGui::TextColored(ImVec4(1.00f, 0.85f, 0.20f, 1.00f), "%c", processes.state[index]);
+                    } else {
+                        ImGui::Text("%c", processes.state[index]);
                     }
-                    
-                    // Start new async calculation
-                    cpuFutures[proc.pid] = async(launch::async, GetCPUUsage, proc.pid);
-                    
-                    // Use cached value or 0
-                    cpuUsage = cachedCPUUsage.find(proc.pid) != cachedCPUUsage.end() ? 
-                            cachedCPUUsage[proc.pid] : 0.0f;
-                } else {
-                    // Use cached value while calculation is running
-                    cpuUsage = cachedCPUUsage.find(proc.pid) != cachedCPUUsage.end() ? 
-                            cachedCPUUsage[proc.pid] : 0.0f;
-                }
 
-                ImGui::Text("%.1f", cpuUsage);
+                    ImGui::TableSetColumnIndex(3);
+                    // CPU usage comes from the background sampler
+                    ImGui::Text("%.1f", processes.cpu[index]);
 
-                ImGui::TableSetColumnIndex(4);
-                double memUsage = getProcessMemoryUsage(proc);
-                ImGui::Text("%.1f", memUsage);
+                    ImGui::TableSetColumnIndex(4);
+                    ImGui::Text("%.1f", processes.mem[index]);
+                }
             }
 
             ImGui::EndTable();
@@ -616,16 +1388,12 @@ void networkWindow(const char *id, ImVec2 size, ImVec2 position)
     ImGui::SetWindowSize(id, size);
     ImGui::SetWindowPos(id, position);
 
-    // Get network interfaces
-    static vector<NetworkInterface> interfaces;
-    static float lastUpdate = 0;
+    shared_ptr<const SystemSnapshot> snapshot = getLatestSnapshot();
+    const vector<NetworkInterface>& interfaces = snapshot->interfaces;
     float currentTime = ImGui::GetTime();
 
-    // Update network data every 1 second for responsive monitoring
-    if (currentTime - lastUpdate > 1.0f) {
-        interfaces = getNetworkInterfaces();
-        lastUpdate = currentTime;
-    }
+    const map<string, TieredHistory>& rxHistory = histories.rx;
+    const map<string, TieredHistory>& txHistory = histories.tx;
 
     if (interfaces.empty()) {
         ImGui::Text("No network interfaces found");
@@ -649,6 +1417,21 @@ void networkWindow(const char *id, ImVec2 size, ImVec2 position)
         return string(buffer);
     };
 
+    // Link speeds are quoted in decimal bits per second
+    auto formatBits = [](double bits) -> string {
+        const char* units[] = {"bit/s", "kbit/s", "Mbit/s", "Gbit/s", "Tbit/s"};
+        int unit = 0;
+
+        while (bits >= 1000.0 && unit < 4) {
+            bits /= 1000.0;
+            unit++;
+        }
+
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "%.1f %s", bits, units[unit]);
+        return string(buffer);
+    };
+
     // Network Interface Information
     if (ImGui::CollapsingHeader("Network Interfaces", ImGuiTreeNodeFlags_DefaultOpen)) {
         for (const auto& iface : interfaces) {
@@ -674,10 +1457,11 @@ void networkWindow(const char *id, ImVec2 size, ImVec2 position)
     if (ImGui::BeginTabBar("NetworkUsageTabs")) {
         // RX (Receive) Tab
         if (ImGui::BeginTabItem("RX (Receive)")) {
-            static map<string, vector<float>> rxHistory;
+            static int range = 0;
             static bool animate = true;
             static float fps = 60.0f;
             static float lastGraphUpdate = 0;
+            static double graphEnd = 0.0;
 
             // Control panel
             ImGui::TextColored(ImVec4(0.90f, 0.70f, 0.00f, 1.00f), "Controls:");
@@ -685,22 +1469,18 @@ void networkWindow(const char *id, ImVec2 size, ImVec2 position)
             ImGui::Checkbox("Animate", &animate);
             ImGui::SameLine();
             ImGui::SliderFloat("FPS", &fps, 1.0f, 120.0f);
+            ImGui::Combo("Range", &range, historyRangeLabels, IM_ARRAYSIZE(historyRangeLabels));
             ImGui::Spacing();
 
-            // Update graph based on FPS setting (only if animation is enabled)
+            // Scroll the graphs at the FPS setting (only if animation is enabled)
             float updateInterval = 1.0f / fps; // Convert FPS to update interval
-            bool shouldUpdate = animate && (currentTime - lastGraphUpdate > updateInterval);
+            if (animate && (currentTime - lastGraphUpdate > updateInterval)) {
+                graphEnd = snapshot->timestamp;
+                lastGraphUpdate = currentTime;
+            }
 
             for (const auto& iface : interfaces) {
                 if (ImGui::CollapsingHeader(iface.name.c_str(), ImGuiTreeNodeFlags_DefaultOpen)) {
-                    // Update RX history based on FPS
-                    if (shouldUpdate) {
-                        rxHistory[iface.name].push_back((float)iface.rx.bytes);
-                        if (rxHistory[iface.name].size() > 100) {
-                            rxHistory[iface.name].erase(rxHistory[iface.name].begin());
-                        }
-                    }
-
                     // RX Table
                     if (ImGui::BeginTable(("RXTable" + iface.name).c_str(), 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
                         ImGui::TableSetupColumn("Metric");
@@ -733,35 +1513,42 @@ void networkWindow(const char *id, ImVec2 size, ImVec2 position)
                         ImGui::TableSetColumnIndex(2); ImGui::Text("Multicast");
                         ImGui::TableSetColumnIndex(3); ImGui::Text("%lld", iface.rx.multicast);
 
+                        ImGui::TableNextRow();
+                        ImGui::TableSetColumnIndex(0); ImGui::Text("Rate");
+                        ImGui::TableSetColumnIndex(1); ImGui::Text("%s", formatBits(iface.rates.rxBytes * 8.0).c_str());
+                        ImGui::TableSetColumnIndex(2); ImGui::Text("Packets/s");
+                        ImGui::TableSetColumnIndex(3); ImGui::Text("%.1f", iface.rates.rxPackets);
+
+                        ImGui::TableNextRow();
+                        ImGui::TableSetColumnIndex(0); ImGui::Text("Errors/s");
+                        ImGui::TableSetColumnIndex(1); ImGui::Text("%.1f", iface.rates.rxErrs);
+                        ImGui::TableSetColumnIndex(2); ImGui::Text("Dropped/s");
+                        ImGui::TableSetColumnIndex(3); ImGui::Text("%.1f", iface.rates.rxDrop);
+
                         ImGui::EndTable();
                     }
 
                     // RX Visual representation
-                    if (!rxHistory[iface.name].empty()) {
-                        ImGui::Text("RX Usage Graph:");
-                        ImGui::PlotLines(("RX " + iface.name).c_str(),
-                                       rxHistory[iface.name].data(),
-                                       rxHistory[iface.name].size(),
-                                       0, formatBytes(iface.rx.bytes).c_str(),
-                                       0.0f, FLT_MAX, ImVec2(0, 80));
+                    const TieredHistory* history = findHistory(rxHistory, iface.name);
+                    if (history && !history->empty()) {
+                        ImGui::Text("RX Throughput:");
+                        float scale = plotHistory(("RX " + iface.name).c_str(), *history, graphEnd, historyRanges[range],
+                                                  formatBits(iface.rates.rxBytes * 8.0).c_str(), 0.0f, FLT_MAX, ImVec2(0, 80));
+                        ImGui::Text("Scale: 0 - %s", formatBits(scale).c_str());
                     }
                 }
             }
 
-            // Update the graph update timer
-            if (shouldUpdate) {
-                lastGraphUpdate = currentTime;
-            }
-
             ImGui::EndTabItem();
         }
 
         // TX (Transmit) Tab
         if (ImGui::BeginTabItem("TX (Transmit)")) {
-            static map<string, vector<float>> txHistory;
+            static int range = 0;
             static bool animate = true;
             static float fps = 60.0f;
             static float lastGraphUpdate = 0;
+            static double graphEnd = 0.0;
 
             // Control panel
             ImGui::TextColored(ImVec4(0.90f, 0.70f, 0.00f, 1.00f), "Controls:");
@@ -769,22 +1556,18 @@ void networkWindow(const char *id, ImVec2 size, ImVec2 position)
             ImGui::Checkbox("Animate", &animate);
             ImGui::SameLine();
             ImGui::SliderFloat("FPS", &fps, 1.0f, 120.0f);
+            ImGui::Combo("Range", &range, historyRangeLabels, IM_ARRAYSIZE(historyRangeLabels));
             ImGui::Spacing();
 
-            // Update graph based on FPS setting (only if animation is enabled)
+            // Scroll the graphs at the FPS setting (only if animation is enabled)
             float updateInterval = 1.0f / fps; // Convert FPS to update interval
-            bool shouldUpdate = animate && (currentTime - lastGraphUpdate > updateInterval);
+            if (animate && (currentTime - lastGraphUpdate > updateInterval)) {
+                graphEnd = snapshot->timestamp;
+                lastGraphUpdate = currentTime;
+            }
 
             for (const auto& iface : interfaces) {
                 if (ImGui::CollapsingHeader(iface.name.c_str(), ImGuiTreeNodeFlags_DefaultOpen)) {
-                    // Update TX history based on FPS
-                    if (shouldUpdate) {
-                        txHistory[iface.name].push_back((float)iface.tx.bytes);
-                        if (txHistory[iface.name].size() > 100) {
-                            txHistory[iface.name].erase(txHistory[iface.name].begin());
-                        }
-                    }
-
                     // TX Table
                     if (ImGui::BeginTable(("TXTable" + iface.name).c_str(), 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
                         ImGui::TableSetupColumn("Metric");
@@ -817,26 +1600,32 @@ void networkWindow(const char *id, ImVec2 size, ImVec2 position)
                         ImGui::TableSetColumnIndex(2); ImGui::Text("Compressed");
                         ImGui::TableSetColumnIndex(3); ImGui::Text("%lld", iface.tx.compressed);
 
+                        ImGui::TableNextRow();
+                        ImGui::TableSetColumnIndex(0); ImGui::Text("Rate");
+                        ImGui::TableSetColumnIndex(1); ImGui::Text("%s", formatBits(iface.rates.txBytes * 8.0).c_str());
+                        ImGui::TableSetColumnIndex(2); ImGui::Text("Packets/s");
+                        ImGui::TableSetColumnIndex(3); ImGui::Text("%.1f", iface.rates.txPackets);
+
+                        ImGui::TableNextRow();
+                        ImGui::TableSetColumnIndex(0); ImGui::Text("Errors/s");
+                        ImGui::TableSetColumnIndex(1); ImGui::Text("%.1f", iface.rates.txErrs);
+                        ImGui::TableSetColumnIndex(2); ImGui::Text("Dropped/s");
+                        ImGui::TableSetColumnIndex(3); ImGui::Text("%.1f", iface.rates.txDrop);
+
                         ImGui::EndTable();
                     }
 
                     // TX Visual representation
-                    if (!txHistory[iface.name].empty()) {
-                        ImGui::Text("TX Usage Graph:");
-                        ImGui::PlotLines(("TX " + iface.name).c_str(),
-                                       txHistory[iface.name].data(),
-                                       txHistory[iface.name].size(),
-                                       0, formatBytes(iface.tx.bytes).c_str(),
-                                       0.0f, FLT_MAX, ImVec2(0, 80));
+                    const TieredHistory* history = findHistory(txHistory, iface.name);
+                    if (history && !history->empty()) {
+                        ImGui::Text("TX Throughput:");
+                        float scale = plotHistory(("TX " + iface.name).c_str(), *history, graphEnd, historyRanges[range],
+                                                  formatBits(iface.rates.txBytes * 8.0).c_str(), 0.0f, FLT_MAX, ImVec2(0, 80));
+                        ImGui::Text("Scale: 0 - %s", formatBits(scale).c_str());
                     }
                 }
             }
 
-            // Update the graph update timer
-            if (shouldUpdate) {
-                lastGraphUpdate = currentTime;
-            }
-
             ImGui::EndTabItem();
         }
 
@@ -949,9 +1738,105 @@ void setupEnhancedStyle()
     style.TabRounding                       = 4;
 }
 
+// Playback position of a --replay recording
+struct ReplayControl {
+    double time = 0.0; // sampler clock of the recording, seconds
+    bool playing = false;
+    int speed = 1;     // index into replaySpeeds
+};
+
+static const float replaySpeeds[] = {0.5f, 1.0f, 2.0f, 5.0f, 10.0f, 60.0f};
+static const char* replaySpeedLabels[] = {"0.5x", "1x", "2x", "5x", "10x", "60x"};
+
+// Play/pause, speed and a scrub slider over the whole recording. Publishes
+// the snapshot at the new position, so the other windows show the recording
+// exactly as they show live data.
+void replayWindow(const char *id, ImVec2 size, ImVec2 position, SnapshotReplay& replay, ReplayControl& control)
+{
+    ImGui::Begin(id);
+    ImGui::SetWindowSize(id, size);
+    ImGui::SetWindowPos(id, position);
+
+    if (control.playing) {
+        // Capped so the first frame after a long idle wait does not jump ahead
+        control.time += min(ImGui::GetIO().DeltaTime, 0.25f) * replaySpeeds[control.speed];
+        if (control.time >= replay.endTime()) {
+            control.time = replay.endTime();
+            control.playing = false;
+        }
+    }
+
+    if (ImGui::Button(control.playing ? "Pause" : "Play", ImVec2(60, 0))) {
+        // Play at the end starts over
+        if (!control.playing && control.time >= replay.endTime()) {
+            control.time = replay.startTime();
+        }
+        control.playing = !control.playing;
+    }
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(80);
+    ImGui::Combo("Speed", &control.speed, replaySpeedLabels, IM_ARRAYSIZE(replaySpeedLabels));
+
+    // Wall clock of the current position, from the recording's start time
+    time_t wallClock = (time_t)((replay.wallClockStart() + (int64_t)(control.time * 1000.0)) / 1000);
+    char clockText[32];
+    strftime(clockText, sizeof(clockText), "%Y-%m-%d %H:%M:%S", localtime(&wallClock));
+    ImGui::SameLine();
+    ImGui::Text("%s", clockText);
+
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(-1);
+    float scrub = (float)control.time;
+    if (ImGui::SliderFloat("##Position", &scrub, (float)replay.startTime(), (float)replay.endTime(), "%.1f s")) {
+        control.time = scrub;
+    }
+
+    shared_ptr<const SystemSnapshot> snapshot = replay.seek(control.time);
+    if (snapshot && snapshot != getLatestSnapshot()) {
+        publishSnapshot(snapshot);
+    }
+
+    ImGui::End();
+}
+
 // Main code
-int main(int, char **)
+int main(int argc, char **argv)
 {
+    // Servers without a display get the collectors only, before any SDL setup
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            return runHeadless(argc, argv);
+        }
+    }
+
+    // Upper bound on redraws per second, on top of vsync
+    int maxFps = 60;
+    const char* metricsAddress = nullptr;
+    const char* recordPath = nullptr;
+    const char* replayPath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--max-fps") == 0 && i + 1 < argc) {
+            maxFps = max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+            metricsAddress = argv[++i];
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        }
+    }
+
+    // A replay shows a recording instead of running the collectors
+    SnapshotReplay replay;
+    ReplayControl replayControl;
+    if (replayPath) {
+        if (!replay.open(replayPath)) {
+            return 1;
+        }
+        replayControl.time = replay.startTime();
+        replayControl.playing = true;
+    }
+
     // Setup SDL
     // (Some versions of SDL before <2.0.10 appears to have performance/stalling issues on a minority of Windows systems,
     // depending on whether SDL_INIT_GAMECONTROLLER is enabled or disabled.. updating to latest version of SDL is recommended!)
@@ -1024,7 +1909,39 @@ int main(int, char **)
     // Enhanced background color - Dark gradient-like background
     ImVec4 clear_color = ImVec4(0.08f, 0.08f, 0.10f, 1.00f);
 
-    // Main loop
+    // All /proc and /sys collection runs on the sampler thread. Each new
+    // snapshot posts an SDL user event that wakes the main loop.
+    Uint32 snapshotEvent = SDL_RegisterEvents(1);
+    SamplerConfig samplerConfig;
+    if (snapshotEvent != (Uint32)-1) {
+        samplerConfig.onSnapshot = [snapshotEvent]() {
+            SDL_Event wake;
+            memset(&wake, 0, sizeof(wake));
+            wake.type = snapshotEvent;
+            SDL_PushEvent(&wake);
+        };
+    }
+    if (recordPath) {
+        samplerConfig.recordPath = recordPath;
+    }
+    if (replayPath) {
+        publishSnapshot(replay.current());
+    } else {
+        startSampler(samplerConfig);
+    }
+    if (metricsAddress) {
+        startExporter(metricsAddress);
+    }
+
+    // Main loop: sleep until input or a new snapshot arrives, then draw.
+    // ImGui needs a couple of extra frames after input for layout and
+    // hover state to settle.
+    const Uint32 minFrameMs = 1000 / maxFps;
+    const int settleFrames = 2;
+    int pendingFrames = settleFrames;
+    unsigned long drawnSequence = 0;
+    unsigned long ingestedSequence = 0;
+    Uint32 lastFrameMs = 0;
     bool done = false;
     while (!done)
     {
@@ -1034,15 +1951,53 @@ int main(int, char **)
         // - When io.WantCaptureKeyboard is true, do not dispatch keyboard input data to your main application.
         // Generally you may always pass all inputs to dear imgui, and hide them from your application based on those two flags.
         SDL_Event event;
-        while (SDL_PollEvent(&event))
+        bool minimized = SDL_GetWindowFlags(window) & (SDL_WINDOW_MINIMIZED | SDL_WINDOW_HIDDEN);
+        int timeoutMs = !minimized && (pendingFrames > 0 || replayControl.playing) ? (int)minFrameMs : 1000;
+        if (SDL_WaitEventTimeout(&event, timeoutMs))
+        {
+            do
+            {
+                if (event.type == snapshotEvent)
+                    continue;
+                ImGui_ImplSDL2_ProcessEvent(&event);
+                pendingFrames = settleFrames;
+                if (event.type == SDL_QUIT)
+                    done = true;
+                if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_CLOSE && event.window.windowID == SDL_GetWindowID(window))
+                    done = true;
+            } while (SDL_PollEvent(&event));
+        }
+
+        // Histories take every snapshot, whether or not a frame is drawn for it
+        shared_ptr<const SystemSnapshot> latest = getLatestSnapshot();
+        unsigned long sequence = latest->sequence;
+        if (sequence != ingestedSequence) {
+            histories.ingest(*latest);
+            ingestedSequence = sequence;
+        }
+
+        // Nothing to draw into while minimized or hidden. The frames owed to the
+        // last event (the minimize itself) are dropped so the wait goes back to
+        // snapshot wake-ups; restoring the window sends an event of its own.
+        if (SDL_GetWindowFlags(window) & (SDL_WINDOW_MINIMIZED | SDL_WINDOW_HIDDEN))
         {
-            ImGui_ImplSDL2_ProcessEvent(&event);
-            if (event.type == SDL_QUIT)
-                done = true;
-            if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_CLOSE && event.window.windowID == SDL_GetWindowID(window))
-                done = true;
+            pendingFrames = 0;
+            continue;
         }
 
+        // Also covers a lost wake-up event: the timeout notices the new sequence
+        if (pendingFrames == 0 && sequence == drawnSequence && !replayControl.playing)
+            continue;
+
+        // Redraw cap
+        Uint32 sinceLastFrame = SDL_GetTicks() - lastFrameMs;
+        if (sinceLastFrame < minFrameMs)
+            SDL_Delay(minFrameMs - sinceLastFrame);
+        lastFrameMs = SDL_GetTicks();
+        drawnSequence = sequence;
+        if (pendingFrames > 0)
+            pendingFrames--;
+
         // Start the Dear ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplSDL2_NewFrame(window);
@@ -1058,9 +2013,17 @@ int main(int, char **)
                          ImVec2((mainDisplay.x / 2) - 10, (mainDisplay.y / 2) + 30),
                          ImVec2(10, 10));
             // --------------------------------------
+            // The replay controls take a strip off the bottom
+            float replayHeight = replayPath ? 50.0f : 0.0f;
             networkWindow("[ Network Activity ]",
-                          ImVec2(mainDisplay.x - 20, (mainDisplay.y / 2) - 60),
+                          ImVec2(mainDisplay.x - 20, (mainDisplay.y / 2) - 60 - replayHeight),
                           ImVec2(10, (mainDisplay.y / 2) + 50));
+            if (replayPath) {
+                replayWindow("[ Replay ]",
+                             ImVec2(mainDisplay.x - 20, replayHeight - 10),
+                             ImVec2(10, mainDisplay.y - replayHeight),
+                             replay, replayControl);
+            }
         }
 
         // Rendering
@@ -1073,6 +2036,8 @@ int main(int, char **)
     }
 
     // Cleanup
+    stopExporter();
+    stopSampler();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplSDL2_Shutdown();
     ImGui::DestroyContext();
@@ -1,147 +1,759 @@
 #include "header.h"
 
-// Get memory information from /proc/meminfo to match 'free -h' command exactly
+// /proc/meminfo keys kept in MemoryInfo. Anything else is skipped.
+struct MeminfoField {
+    const char* key;
+    unsigned long MemoryInfo::*field;
+};
+
+static constexpr MeminfoField meminfoFields[] = {
+    {"MemTotal", &MemoryInfo::totalRAM},
+    {"MemFree", &MemoryInfo::freeRAM},
+    {"MemAvailable", &MemoryInfo::availableRAM},
+    {"Buffers", &MemoryInfo::buffers},
+    {"Cached", &MemoryInfo::cached},
+    {"SwapCached", &MemoryInfo::swapCached},
+    {"Active", &MemoryInfo::active},
+    {"Inactive", &MemoryInfo::inactive},
+    {"SwapTotal", &MemoryInfo::totalSwap},
+    {"SwapFree", &MemoryInfo::freeSwap},
+    {"Dirty", &MemoryInfo::dirty},
+    {"Writeback", &MemoryInfo::writeback},
+    {"AnonPages", &MemoryInfo::anonPages},
+    {"Mapped", &MemoryInfo::mapped},
+    {"Shmem", &MemoryInfo::shmem},
+    {"Slab", &MemoryInfo::slab},
+    {"SReclaimable", &MemoryInfo::slabReclaimable},
+    {"SUnreclaim", &MemoryInfo::slabUnreclaimable},
+    {"KernelStack", &MemoryInfo::kernelStack},
+    {"PageTables", &MemoryInfo::pageTables},
+    {"CommitLimit", &MemoryInfo::commitLimit},
+    {"Committed_AS", &MemoryInfo::committed},
+    {"AnonHugePages", &MemoryInfo::anonHugePages},
+    {"HugePages_Total", &MemoryInfo::hugePagesTotal},
+    {"HugePages_Free", &MemoryInfo::hugePagesFree},
+    {"Hugepagesize", &MemoryInfo::hugePageSize},
+};
+
+static constexpr size_t meminfoFieldCount = sizeof(meminfoFields) / sizeof(*meminfoFields);
+static constexpr size_t meminfoSlots = 128; // power of two, well above the key count
+static constexpr uint8_t meminfoEmpty = 0xff;
+
+static constexpr uint32_t meminfoHash(const char* key, size_t len, uint32_t seed)
+{
+    uint32_t hash = seed;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t)key[i]) * 16777619u; // FNV-1a
+    }
+    return hash;
+}
+
+static constexpr size_t constLength(const char* s)
+{
+    size_t len = 0;
+    while (s[len]) len++;
+    return len;
+}
+
+// Key slot -> index into meminfoFields, with the first FNV seed that gives
+// every key its own slot. Searched by the compiler, so a key added above
+// that collides just moves to another seed.
+struct MeminfoTable {
+    uint32_t seed;
+    uint8_t slots[meminfoSlots];
+};
+
+static constexpr MeminfoTable buildMeminfoTable()
+{
+    for (uint32_t seed = 2166136261u;; seed++) {
+        MeminfoTable table = {seed, {}};
+        for (size_t slot = 0; slot < meminfoSlots; slot++) table.slots[slot] = meminfoEmpty;
+
+        bool perfect = true;
+        for (size_t i = 0; i < meminfoFieldCount && perfect; i++) {
+            const char* key = meminfoFields[i].key;
+            size_t slot = meminfoHash(key, constLength(key), seed) & (meminfoSlots - 1);
+            perfect = table.slots[slot] == meminfoEmpty;
+            table.slots[slot] = (uint8_t)i;
+        }
+        if (perfect) return table;
+    }
+}
+
+static constexpr MeminfoTable meminfoTable = buildMeminfoTable();
+static_assert(meminfoFieldCount < meminfoEmpty, "meminfo slot indices are 8-bit");
+
+// Read /proc/meminfo in one pass, "Key:   value kB" per line. Each key is one
+// hash and one compare; unknown keys are skipped without allocating.
+// used = MemTotal - MemAvailable, the same as modern free(1).
 MemoryInfo getMemoryInfo()
 {
+    static vector<char> buf(8192);
+
     MemoryInfo memInfo = {0};
 
-    ifstream file("/proc/meminfo");
-    string line;
-    unsigned long memAvailable = 0;
+    ssize_t len;
+    while (true) {
+        len = readProcFile("/proc/meminfo", buf.data(), buf.size());
+        if (len < 0) return memInfo;
+        if ((size_t)len < buf.size() - 1) break;
+        buf.resize(buf.size() * 2);
+    }
 
-    while (getline(file, line)) {
-        if (line.find("MemTotal:") == 0) {
-            sscanf(line.c_str(), "MemTotal: %lu kB", &memInfo.totalRAM);
-            memInfo.totalRAM *= 1024; // Convert to bytes
+    const char* p = buf.data();
+    const char* end = p + len;
+    while (p < end) {
+        const char* eol = (const char*)memchr(p, '\n', end - p);
+        if (eol == nullptr) eol = end;
+
+        const char* colon = (const char*)memchr(p, ':', eol - p);
+        if (colon != nullptr) {
+            size_t keyLength = colon - p;
+            uint8_t index = meminfoTable.slots[meminfoHash(p, keyLength, meminfoTable.seed) & (meminfoSlots - 1)];
+            if (index != meminfoEmpty && strlen(meminfoFields[index].key) == keyLength &&
+                memcmp(meminfoFields[index].key, p, keyLength) == 0) {
+                const char* q = colon + 1;
+                while (q < eol && *q == ' ') q++;
+
+                long long value;
+                q = scanNumber(q, eol, value);
+                bool kilobytes = eol - q >= 3 && memcmp(q, " kB", 3) == 0;
+                memInfo.*meminfoFields[index].field = (unsigned long)value * (kilobytes ? 1024 : 1);
+            }
         }
-        else if (line.find("MemFree:") == 0) {
-            sscanf(line.c_str(), "MemFree: %lu kB", &memInfo.freeRAM);
-            memInfo.freeRAM *= 1024;
+
+        p = eol + 1;
+    }
+
+    memInfo.usedRAM = memInfo.totalRAM - memInfo.availableRAM;
+    memInfo.usedSwap = memInfo.totalSwap - memInfo.freeSwap;
+
+    return memInfo;
+}
+
+// Filesystems that never hold user data
+static const char* pseudoFilesystems[] = {
+    "proc", "sysfs", "devtmpfs", "devpts", "tmpfs", "ramfs", "cgroup", "cgroup2", "mqueue",
+    "debugfs", "tracefs", "securityfs", "pstore", "bpf", "configfs", "fusectl", "hugetlbfs",
+    "autofs", "binfmt_misc", "rpc_pipefs", "nsfs", "selinuxfs", "efivarfs", "squashfs",
+};
+
+// statvfs on these can block for as long as the server is unreachable, which
+// would stall every other collector on the sampler thread
+static const char* networkFilesystems[] = {
+    "nfs", "nfs4", "cifs", "smb3", "smbfs", "ncpfs", "ceph", "glusterfs", "9p", "afs", "coda",
+    "lustre", "gpfs", "beegfs", "orangefs", "ocfs2", "gfs2", "davfs",
+};
+
+// Any FUSE daemon can be remote (sshfs, rclone, s3fs, gvfs, ...) and a hung one
+// blocks statvfs the same way, so only these known-local drivers are measured.
+// fuseblk is always backed by a local block device.
+static const char* localFuseFilesystems[] = {
+    "fuseblk", "fuse.ntfs-3g", "fuse.exfat", "fuse.ext4fuse",
+};
+
+static bool inList(const string& value, const char* const* list, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (value == list[i]) return true;
+    }
+    return false;
+}
+
+// mountinfo escapes space, tab, newline and backslash as \ooo
+string unescapeMountField(const char* p, const char* end)
+{
+    string out;
+    out.reserve(end - p);
+    while (p < end) {
+        if (*p == '\\' && end - p >= 4) {
+            out += (char)(((p[1] - '0') << 6) | ((p[2] - '0') << 3) | (p[3] - '0'));
+            p += 4;
+        } else {
+            out += *p++;
         }
-        else if (line.find("MemAvailable:") == 0) {
-            sscanf(line.c_str(), "MemAvailable: %lu kB", &memAvailable);
-            memAvailable *= 1024;
+    }
+    return out;
+}
+
+MountTable::~MountTable()
+{
+    close();
+}
+
+// Keep /proc/self/mountinfo open so poll() can report changes. Returns false
+// (and leaves the table re-parsing on every refresh) if it cannot be opened.
+bool MountTable::open()
+{
+    if (active()) return true;
+    fd = ::open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC);
+    stale = true;
+    return active();
+}
+
+void MountTable::close()
+{
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    stale = true;
+}
+
+// mountinfo line:
+//   36 35 98:0 /mnt1 /mnt/parent rw,noatime master:1 - ext3 /dev/root rw,errors=continue
+//   id parent major:minor root mountpoint options [optional fields...] - fstype source superoptions
+void MountTable::refresh()
+{
+    static vector<char> buf(16384);
+
+    if (active() && !stale) {
+        struct pollfd pfd = {fd, POLLPRI, 0};
+        if (poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLPRI | POLLERR))) {
+            stale = true;
         }
-        else if (line.find("SwapTotal:") == 0) {
-            sscanf(line.c_str(), "SwapTotal: %lu kB", &memInfo.totalSwap);
-            memInfo.totalSwap *= 1024;
+    }
+    if (active() && !stale) return;
+
+    // Reading from the start is what re-arms the poll notification
+    size_t len = 0;
+    int readFd = active() ? fd : ::open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC);
+    if (readFd < 0) return;
+    lseek(readFd, 0, SEEK_SET);
+    while (true) {
+        if (len == buf.size()) buf.resize(buf.size() * 2);
+        ssize_t n = read(readFd, buf.data() + len, buf.size() - len);
+        if (n <= 0) break;
+        len += n;
+    }
+    if (readFd != fd) ::close(readFd);
+
+    mounts.clear();
+    set<string> devices; // major:minor already listed, so bind mounts appear once
+    const char* p = buf.data();
+    const char* end = p + len;
+    while (p < end) {
+        const char* eol = (const char*)memchr(p, '\n', end - p);
+        if (eol == nullptr) eol = end;
+
+        // Split on spaces; the optional fields end at a lone "-"
+        const char* fields[12];
+        const char* fieldEnds[12];
+        int count = 0;
+        int separator = -1;
+        for (const char* q = p; q < eol && count < 12;) {
+            const char* next = (const char*)memchr(q, ' ', eol - q);
+            if (next == nullptr) next = eol;
+            fields[count] = q;
+            fieldEnds[count] = next;
+            if (separator < 0 && next - q == 1 && *q == '-') separator = count;
+            count++;
+            q = next + 1;
         }
-        else if (line.find("SwapFree:") == 0) {
-            sscanf(line.c_str(), "SwapFree: %lu kB", &memInfo.freeSwap);
-            memInfo.freeSwap *= 1024;
+        p = eol + 1;
+        if (separator < 6 || separator + 2 >= count) continue;
+
+        Mount mount;
+        mount.mountPoint = unescapeMountField(fields[4], fieldEnds[4]);
+        mount.fsType.assign(fields[separator + 1], fieldEnds[separator + 1]);
+        mount.device = unescapeMountField(fields[separator + 2], fieldEnds[separator + 2]);
+
+        bool fuse = mount.fsType.compare(0, 4, "fuse") == 0;
+        if (inList(mount.fsType, pseudoFilesystems, sizeof(pseudoFilesystems) / sizeof(*pseudoFilesystems)) ||
+            inList(mount.fsType, networkFilesystems, sizeof(networkFilesystems) / sizeof(*networkFilesystems)) ||
+            (fuse && !inList(mount.fsType, localFuseFilesystems,
+                             sizeof(localFuseFilesystems) / sizeof(*localFuseFilesystems)))) {
+            continue;
+        }
+        if (!devices.insert(string(fields[2], fieldEnds[2])).second) continue;
+
+        // Root first, the rest in mount order
+        if (mount.mountPoint == "/") {
+            mounts.insert(mounts.begin(), move(mount));
+        } else {
+            mounts.push_back(move(mount));
         }
     }
+    stale = false;
+}
 
-    // Calculate used memory exactly the same way modern 'free' command does:
-    // Used = MemTotal - MemAvailable
-    // This matches the 'free -h' output perfectly
-    memInfo.usedRAM = memInfo.totalRAM - memAvailable;
-    memInfo.usedSwap = memInfo.totalSwap - memInfo.freeSwap;
+// Space on every filesystem in the table, computed the same way df does:
+// Total = total blocks * block size
+// Available = available blocks * block size (f_bavail accounts for reserved space)
+// Used = Total - Free (using f_bfree, not f_bavail, to match df calculation)
+vector<DiskInfo> getFilesystemUsage(MountTable& table)
+{
+    table.refresh();
+
+    vector<DiskInfo> filesystems;
+    filesystems.reserve(table.mounts.size());
+    for (const auto& mount : table.mounts) {
+        struct statvfs stat;
+        if (statvfs(mount.mountPoint.c_str(), &stat) != 0 || stat.f_blocks == 0) continue;
+
+        DiskInfo disk;
+        disk.totalDisk = stat.f_blocks * stat.f_frsize;
+        disk.freeDisk = stat.f_bavail * stat.f_frsize;  // Available to non-root users
+        disk.usedDisk = disk.totalDisk - stat.f_bfree * stat.f_frsize;
+        disk.filesystem = mount.device;
+        disk.mountPoint = mount.mountPoint;
+        disk.fsType = mount.fsType;
+        filesystems.push_back(move(disk));
+    }
+    return filesystems;
+}
 
-    return memInfo;
+// Whole devices are the ones listed in /sys/block; partitions are not. Loop
+// and RAM disks are left out. Looked up once per device name.
+static bool isWholeDisk(const string& name)
+{
+    static map<string, bool> known;
+
+    auto it = known.find(name);
+    if (it != known.end()) return it->second;
+
+    bool whole = name.compare(0, 4, "loop") != 0 && name.compare(0, 3, "ram") != 0 &&
+                 access(("/sys/block/" + name).c_str(), F_OK) == 0;
+    known[name] = whole;
+    return whole;
 }
 
-// Get disk information using statvfs
-DiskInfo getDiskInfo()
+// Parse /proc/diskstats in one pass:
+//   major minor name reads merged sectors ms writes merged sectors ms in_flight io_ms weighted_ms ...
+// The buffer is kept between calls and only grows if the file does not fit.
+vector<DiskIOStats> getDiskIOStats()
 {
-    DiskInfo diskInfo = {0};
-    diskInfo.filesystem = "Unknown";
+    static vector<char> buf(16384);
+    static string name;
+
+    vector<DiskIOStats> devices;
+
+    ssize_t len;
+    while (true) {
+        len = readProcFile("/proc/diskstats", buf.data(), buf.size());
+        if (len < 0) return devices;
+        if ((size_t)len < buf.size() - 1) break;
+        buf.resize(buf.size() * 2);
+    }
 
-    // Get filesystem name from /proc/mounts
-    ifstream mountsFile("/proc/mounts");
-    string line;
-    while (getline(mountsFile, line)) {
-        istringstream iss(line);
-        string device, mountpoint, fstype;
-        if (iss >> device >> mountpoint >> fstype) {
-            if (mountpoint == "/") {
-                diskInfo.filesystem = device;
+    const char* p = buf.data();
+    const char* end = p + len;
+    while (p < end) {
+        const char* eol = (const char*)memchr(p, '\n', end - p);
+        if (eol == nullptr) eol = end;
+
+        // Skip major and minor, then the device name
+        long long major, minor;
+        const char* q = p;
+        while (q < eol && *q == ' ') q++;
+        q = scanNumber(q, eol, major);
+        while (q < eol && *q == ' ') q++;
+        q = scanNumber(q, eol, minor);
+        while (q < eol && *q == ' ') q++;
+        const char* nameStart = q;
+        while (q < eol && *q != ' ') q++;
+        name.assign(nameStart, q - nameStart);
+        p = eol + 1;
+
+        if (name.empty() || !isWholeDisk(name)) continue;
+
+        long long fields[10] = {0};
+        for (int i = 0; i < 10 && q < eol; i++) {
+            while (q < eol && *q == ' ') q++;
+            q = scanNumber(q, eol, fields[i]);
+        }
+
+        DiskIOStats device;
+        device.name = name;
+        device.reads = fields[0];
+        device.readSectors = fields[2];
+        device.readTicks = fields[3];
+        device.writes = fields[4];
+        device.writeSectors = fields[6];
+        device.writeTicks = fields[7];
+        device.ioTicks = fields[9];
+        devices.push_back(move(device));
+    }
+
+    return devices;
+}
+
+// Fill in per-second rates for each device from its previous sample, the same
+// way iostat does. New devices start at zero; a zero-length interval keeps
+// the previous rates.
+void computeDiskIORates(vector<DiskIOStats>& current, const vector<DiskIOStats>& previous, double elapsed)
+{
+    for (auto& device : current) {
+        const DiskIOStats* prev = nullptr;
+        for (const auto& candidate : previous) {
+            if (candidate.name == device.name) {
+                prev = &candidate;
                 break;
             }
         }
+
+        device.readOps = device.writeOps = device.readBytes = device.writeBytes = 0.0;
+        device.await = device.util = 0.0;
+        if (prev == nullptr) continue;
+        if (elapsed <= 0.0) {
+            device.readOps = prev->readOps;
+            device.writeOps = prev->writeOps;
+            device.readBytes = prev->readBytes;
+            device.writeBytes = prev->writeBytes;
+            device.await = prev->await;
+            device.util = prev->util;
+            continue;
+        }
+
+        uint64_t reads = counterDelta(prev->reads, device.reads);
+        uint64_t writes = counterDelta(prev->writes, device.writes);
+        uint64_t ticks = counterDelta(prev->readTicks, device.readTicks) + counterDelta(prev->writeTicks, device.writeTicks);
+
+        device.readOps = reads / elapsed;
+        device.writeOps = writes / elapsed;
+        device.readBytes = counterDelta(prev->readSectors, device.readSectors) * 512.0 / elapsed;
+        device.writeBytes = counterDelta(prev->writeSectors, device.writeSectors) * 512.0 / elapsed;
+        device.await = reads + writes ? (double)ticks / (reads + writes) : 0.0;
+        device.util = min(100.0, counterDelta(prev->ioTicks, device.ioTicks) / (elapsed * 1000.0) * 100.0);
     }
+}
 
-    struct statvfs stat;
-    if (statvfs("/", &stat) == 0) {
-        // Calculate the same way df does:
-        // Total = total blocks * block size
-        // Available = available blocks * block size (f_bavail accounts for reserved space)
-        // Free = free blocks * block size (f_bfree includes reserved space)
-        // Used = Total - Free (using f_bfree, not f_bavail, to match df calculation)
-        diskInfo.totalDisk = stat.f_blocks * stat.f_frsize;
-        diskInfo.freeDisk = stat.f_bavail * stat.f_frsize;  // Available to non-root users
-        unsigned long actualFree = stat.f_bfree * stat.f_frsize;  // Total free including reserved
-        diskInfo.usedDisk = diskInfo.totalDisk - actualFree;  // This matches df calculation
+// Read a small /proc file into buf with a single read(), NUL-terminated.
+// Returns the number of bytes read, or -1 if the file is gone.
+ssize_t readProcFile(const char* path, char* buf, size_t size)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    ssize_t len = read(fd, buf, size - 1);
+    close(fd);
+    if (len < 0) return -1;
+
+    buf[len] = '\0';
+    return len;
+}
+
+// Parse one /proc/PID/stat line in place:
+// pid (comm) state ppid pgrp session tty_nr tpgid flags minflt cminflt majflt cmajflt utime stime cutime cstime priority nice num_threads itrealvalue starttime vsize rss rsslim...
+// comm may itself contain spaces and ')', so fields are counted from the last ')'.
+bool parseProcStat(const char* buf, size_t len, Proc& proc)
+{
+    const char* end = buf + len;
+    const char* nameStart = (const char*)memchr(buf, '(', len);
+    const char* nameEnd = (const char*)memrchr(buf, ')', len);
+    if (nameStart == nullptr || nameEnd == nullptr || nameEnd < nameStart || nameEnd + 2 >= end) return false;
+
+    proc.name.assign(nameStart + 1, nameEnd - nameStart - 1);
+    proc.state = nameEnd[2];
+
+    // Fields 4 (ppid) through 24 (rss) are all integers
+    const char* p = nameEnd + 3;
+    for (int field = 4; field <= 24; field++) {
+        while (p < end && *p == ' ') p++;
+        if (p >= end) return false;
+
+        long long value;
+        p = scanNumber(p, end, value);
+
+        switch (field) {
+        case 14: proc.utime = value; break;  // user time
+        case 15: proc.stime = value; break;  // system time
+        case 22: proc.starttime = value; break; // start time after boot
+        case 23: proc.vsize = value; break;  // virtual memory size
+        case 24: proc.rss = value; break;    // resident set size in pages
+        }
     }
 
-    return diskInfo;
+    return true;
 }
 
-// Get list of all processes
-vector<Proc> getProcessList()
+// Descriptors left for everything else in the process (GL, sockets, logs)
+static const rlim_t reservedFds = 128;
+
+ProcFdCache::ProcFdCache(size_t requestedBudget)
+{
+    rlim_t available = 1024;
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        available = limit.rlim_cur == RLIM_INFINITY ? 65536 : limit.rlim_cur;
+    }
+
+    budget = available > reservedFds ? available - reservedFds : 0;
+    if (requestedBudget > 0) {
+        budget = min(budget, (size_t)requestedBudget);
+    }
+}
+
+ProcFdCache::~ProcFdCache()
 {
-    vector<Proc> processes;
+    for (const auto& entry : entries) {
+        close(entry.second.fd);
+    }
+}
 
-    DIR* procDir = opendir("/proc");
-    if (procDir == nullptr) return processes;
+// Start a readdir pass; PIDs not read before endScan() are evicted
+void ProcFdCache::beginScan()
+{
+    generation++;
+}
 
-    struct dirent* entry;
-    while ((entry = readdir(procDir)) != nullptr) {
-        // Check if directory name is a number (PID)
-        if (strspn(entry->d_name, "0123456789") == strlen(entry->d_name)) {
-            Proc proc = {0};
-            proc.pid = atoi(entry->d_name);
+ssize_t ProcFdCache::readStat(int pid, char* buf, size_t size)
+{
+    auto it = entries.find(pid);
+    if (it != entries.end()) {
+        ssize_t len = pread(it->second.fd, buf, size - 1, 0);
+        if (len >= 0) {
+            it->second.generation = generation;
+            buf[len] = '\0';
+            return len;
+        }
+        // ESRCH: the process exited, possibly with the PID already reused.
+        // Drop the stale descriptor and try a fresh open below.
+        evict(pid);
+    }
 
-            // Read process name from /proc/PID/comm
-            string commPath = "/proc/" + string(entry->d_name) + "/comm";
-            ifstream commFile(commPath);
-            if (commFile.is_open()) {
-                getline(commFile, proc.name);
-            }
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1; // ENOENT: the process is gone
 
-            // Read process stats from /proc/PID/stat
-            string statPath = "/proc/" + string(entry->d_name) + "/stat";
-            ifstream statFile(statPath);
-            string line;
+    ssize_t len = pread(fd, buf, size - 1, 0);
+    if (len < 0) {
+        close(fd);
+        return -1;
+    }
+    buf[len] = '\0';
+
+    // Over budget the read still succeeds, the descriptor just is not kept
+    if (entries.size() < budget) {
+        entries[pid] = {fd, generation};
+    } else {
+        close(fd);
+    }
+
+    return len;
+}
+
+// Close descriptors of PIDs that disappeared from /proc during this pass
+void ProcFdCache::endScan()
+{
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->second.generation != generation) {
+            close(it->second.fd);
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ProcFdCache::evict(int pid)
+{
+    auto it = entries.find(pid);
+    if (it != entries.end()) {
+        close(it->second.fd);
+        entries.erase(it);
+    }
+}
+
+ProcEventListener::~ProcEventListener()
+{
+    close();
+}
+
+// Subscribe to the proc connector. Returns false (and leaves the listener
+// inactive) when netlink or the multicast group is not permitted.
+bool ProcEventListener::open()
+{
+    if (active()) return true;
+
+    sock = socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    if (sock < 0) return false;
+
+    // Events are only drained once per scan, so leave room for bursts of churn
+    int rcvbuf = 1 << 20;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    struct sockaddr_nl addr = {};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = CN_IDX_PROC;
+    if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close();
+        return false;
+    }
+
+    // nlmsghdr + cn_msg + PROC_CN_MCAST_LISTEN
+    alignas(struct nlmsghdr) char request[NLMSG_SPACE(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op))] = {};
+    struct nlmsghdr* header = (struct nlmsghdr*)request;
+    header->nlmsg_len = NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op));
+    header->nlmsg_type = NLMSG_DONE;
+
+    struct cn_msg* message = (struct cn_msg*)NLMSG_DATA(header);
+    message->id.idx = CN_IDX_PROC;
+    message->id.val = CN_VAL_PROC;
+    message->len = sizeof(enum proc_cn_mcast_op);
+    enum proc_cn_mcast_op op = PROC_CN_MCAST_LISTEN;
+    memcpy(message->data, &op, sizeof(op));
+
+    if (send(sock, request, header->nlmsg_len, 0) < 0) {
+        close();
+        return false;
+    }
 
-            if (getline(statFile, line)) {
-                // Parse stat file - format is complex, we need specific fields
-                // The stat file format: pid (comm) state ppid pgrp session tty_nr tpgid flags minflt cminflt majflt cmajflt utime stime cutime cstime priority nice num_threads itrealvalue starttime vsize rss rsslim...
-                istringstream iss(line);
-                string token;
-                vector<string> tokens;
+    synced = false;
+    return true;
+}
 
-                while (iss >> token) {
-                    tokens.push_back(token);
+void ProcEventListener::close()
+{
+    if (sock >= 0) {
+        ::close(sock);
+        sock = -1;
+    }
+    synced = false;
+    pids.clear();
+}
+
+// Apply every queued event to the PID set without blocking
+void ProcEventListener::drain()
+{
+    if (!active()) return;
+
+    alignas(struct nlmsghdr) char buf[8192];
+    while (true) {
+        ssize_t len = recv(sock, buf, sizeof(buf), 0);
+        if (len < 0) {
+            // ENOBUFS means events were dropped, so the PID set can no longer be trusted
+            if (errno == ENOBUFS) synced = false;
+            if (errno == EINTR || errno == ENOBUFS) continue;
+            break;
+        }
+
+        for (struct nlmsghdr* header = (struct nlmsghdr*)buf; NLMSG_OK(header, len);
+             header = NLMSG_NEXT(header, len)) {
+            if (header->nlmsg_type == NLMSG_ERROR || header->nlmsg_type == NLMSG_NOOP) continue;
+
+            struct cn_msg* message = (struct cn_msg*)NLMSG_DATA(header);
+            if (message->id.idx != CN_IDX_PROC || message->id.val != CN_VAL_PROC) continue;
+
+            struct proc_event* event = (struct proc_event*)message->data;
+            switch (event->what) {
+            case proc_event::PROC_EVENT_FORK:
+                // Threads fork too; only a new thread group is a new process
+                if (event->event_data.fork.child_pid == event->event_data.fork.child_tgid) {
+                    pids.insert(event->event_data.fork.child_tgid);
+                    forks++;
                 }
+                break;
+            case proc_event::PROC_EVENT_EXEC:
+                execs++;
+                break;
+            case proc_event::PROC_EVENT_EXIT:
+                // A leader exiting while other threads run leaves the process
+                // alive, so the PID stays until a scan can no longer read it
+                break;
+            default:
+                break;
+            }
+        }
+    }
+}
+
+// Walk /proc once: every PID's stat line is read a single time and feeds the
+// process list, the per-state histogram and the top-style totals together.
+// With an active ProcEventListener the PID set comes from kernel events and
+// readdir only runs to (re)synchronize it.
+ProcessScan scanProcesses(ProcFdCache* cache, ProcEventListener* events)
+{
+    ProcessScan scan;
+    scan.stateCounts = emptyProcessStateCounts();
+
+    // Reused for every PID, so the walk does no per-process allocation
+    char path[64];
+    char buf[1024];
+
+    // Read one PID into the scan; false if the process is already gone
+    auto addProcess = [&](int pid) {
+        Proc proc = {0};
+        proc.pid = pid;
+
+        // The name is taken from the stat line too, which saves opening /proc/PID/comm
+        ssize_t len;
+        if (cache != nullptr) {
+            len = cache->readStat(pid, buf, sizeof(buf));
+        } else {
+            snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+            len = readProcFile(path, buf, sizeof(buf));
+        }
+        if (len <= 0) return false; // process exited while we were scanning
+
+        if (!parseProcStat(buf, len, proc)) {
+            proc.state = '?';
+        }
 
-                if (tokens.size() >= 24) {
-                    // Ensure we have a valid state character
-                    if (!tokens[2].empty()) {
-                        proc.state = tokens[2][0]; // 3rd field (0-indexed) - process state
-                    } else {
-                        proc.state = '?'; // Unknown state if empty
+        auto state = scan.stateCounts.find(proc.state);
+        if (state != scan.stateCounts.end()) {
+            state->second++;
+        }
+
+        scan.processes.push_back(move(proc));
+        return true;
+    };
+
+    if (cache != nullptr) cache->beginScan();
+
+    if (events != nullptr && events->active()) {
+        events->drain();
+        scan.eventDriven = true;
+        scan.forks = events->forks;
+        events->forks = events->execs = 0;
+    }
+
+    if (scan.eventDriven && events->synced) {
+        for (auto it = events->pids.begin(); it != events->pids.end();) {
+            if (addProcess(*it)) {
+                ++it;
+            } else {
+                it = events->pids.erase(it);
+                scan.exits++;
+            }
+        }
+    } else {
+        DIR* procDir = opendir("/proc");
+        if (procDir != nullptr) {
+            set<int> seen;
+
+            struct dirent* entry;
+            while ((entry = readdir(procDir)) != nullptr) {
+                // Check if directory name is a number (PID)
+                if (strspn(entry->d_name, "0123456789") == strlen(entry->d_name)) {
+                    int pid = atoi(entry->d_name);
+                    if (addProcess(pid) && scan.eventDriven) {
+                        seen.insert(pid);
                     }
-                    proc.vsize = stoll(tokens[22]); // 23rd field - virtual memory size
-                    proc.rss = stoll(tokens[23]); // 24th field - resident set size
-                    proc.utime = stoll(tokens[13]); // 14th field - user time
-                    proc.stime = stoll(tokens[14]); // 15th field - system time
-                } else {
-                    // If we don't have enough fields, set default values
-                    proc.state = '?';
-                    proc.vsize = 0;
-                    proc.rss = 0;
-                    proc.utime = 0;
-                    proc.stime = 0;
                 }
             }
 
-            processes.push_back(proc);
+            closedir(procDir);
+
+            // Events queued during the walk are applied on top at the next drain
+            if (scan.eventDriven) {
+                events->pids.swap(seen);
+                events->synced = true;
+            }
         }
     }
 
-    closedir(procDir);
-    return processes;
+    if (cache != nullptr) cache->endScan();
+
+    scan.topCounts = summarizeProcessStates(scan.stateCounts);
+    return scan;
+}
+
+// Get list of all processes
+vector<Proc> getProcessList()
+{
+    return scanProcesses().processes;
 }
 
 // Calculate CPU usage for a specific process (matches top command calculation exactly)
@@ -202,142 +814,132 @@ double getProcessCPUUsage(const Proc& proc)
     return 0.0;
 }
 
-// Get current process state in real-time (like top does)
-char getCurrentProcessState(int pid)
+// Diff every process against the previous sample in a single pass
+map<int, float> ProcessCPUSampler::update(const vector<Proc>& processes, const CPUStats& cpu)
 {
-    string statPath = "/proc/" + to_string(pid) + "/stat";
-    ifstream statFile(statPath);
-    string line;
-
-    if (getline(statFile, line)) {
-        // Find the last ')' to handle process names with spaces/parentheses
-        size_t lastParen = line.find_last_of(')');
-        if (lastParen != string::npos && lastParen + 2 < line.length()) {
-            // State is the first character after ") "
-            char state = line[lastParen + 2];
-            
-         
-            
-            return state;
+    map<int, float> usage;
+
+    long long totalJiffies = cpu.user + cpu.nice + cpu.system + cpu.idle +
+                             cpu.iowait + cpu.irq + cpu.softirq + cpu.steal;
+    long long jiffiesDiff = totalJiffies - prevTotalJiffies;
+    bool havePrevious = prevTotalJiffies > 0 && jiffiesDiff > 0;
+
+    map<int, Ticks> currentTicks;
+    for (const auto& proc : processes) {
+        long long ticks = proc.utime + proc.stime;
+        currentTicks[proc.pid] = {proc.starttime, ticks};
+
+        float cpuUsage = 0.0f;
+        auto prev = prevTicks.find(proc.pid);
+        // A different starttime means the PID was reused, so treat it as a new process
+        if (havePrevious && prev != prevTicks.end() && prev->second.starttime == proc.starttime &&
+            ticks >= prev->second.ticks) {
+            cpuUsage = 100.0f * (float)(ticks - prev->second.ticks) / jiffiesDiff * numCores;
         }
+        usage[proc.pid] = cpuUsage;
     }
 
-    return '?';
+    // Exited processes drop out here because only live PIDs are kept
+    prevTicks.swap(currentTicks);
+    prevTotalJiffies = totalJiffies;
+
+    return usage;
 }
 
-// Calculate memory usage percentage for a process
-double getProcessMemoryUsage(const Proc& proc)
+// Split the scanned processes into columns, with CPU% joined in by PID
+ProcessStore buildProcessStore(const vector<Proc>& processes, const map<int, float>& cpuUsage)
 {
-    MemoryInfo memInfo = getMemoryInfo();
-    if (memInfo.totalRAM > 0) {
-        return (double)(proc.rss * getpagesize()) / memInfo.totalRAM * 100.0;
+    ProcessStore store;
+    size_t count = processes.size();
+    store.pid.reserve(count);
+    store.name.reserve(count);
+    store.state.reserve(count);
+    store.cpu.reserve(count);
+    store.rss.reserve(count);
+    store.starttime.reserve(count);
+
+    for (const auto& proc : processes) {
+        auto cpu = cpuUsage.find(proc.pid);
+        store.pid.push_back(proc.pid);
+        store.name.push_back(proc.name);
+        store.state.push_back(proc.state);
+        store.cpu.push_back(cpu != cpuUsage.end() ? cpu->second : 0.0f);
+        store.rss.push_back(proc.rss);
+        store.starttime.push_back(proc.starttime);
     }
-    return 0.0;
-}
 
-float GetCPUUsage(int pid) {
-    std::string statPath = "/proc/" + std::to_string(pid) + "/stat";
+    return store;
+}
 
-    // Helper lambda to measure process and system CPU time
-    auto measure = [&]() -> std::pair<long, long> {
-        // Open process stat file
-        std::ifstream statFile(statPath);
-        if (!statFile.is_open()) {
-            // std::cerr << "Could not open file: " << statPath << std::endl;
-            return {-1, -1};
-        }
+// MEM% for every row in one pass over the rss column; the page size and the
+// total RAM are hoisted out so the loop is a plain multiply the compiler can vectorize
+void computeProcessMemoryUsage(ProcessStore& store, unsigned long totalRAM)
+{
+    static const long pageSize = getpagesize();
 
-        // Read process stats
-        std::string statLine;
-        if (!std::getline(statFile, statLine)) {
-            std::cerr << "Failed to read from file: " << statPath << std::endl;
-            return {-1, -1};
-        }
+    size_t count = store.size();
+    store.mem.resize(count);
 
-        // Parse stat line into fields
-        std::istringstream iss(statLine);
-        std::vector<std::string> statFields;
-        std::string field;
+    float scale = totalRAM > 0 ? (float)pageSize * 100.0f / (float)totalRAM : 0.0f;
+    const long long* rss = store.rss.data();
+    float* mem = store.mem.data();
+    for (size_t i = 0; i < count; i++) {
+        mem[i] = (float)rss[i] * scale;
+    }
+}
 
-        while (iss >> field) {
-            statFields.push_back(field);
-        }
+// Carry state-change times over from the previous store, stamping rows whose
+// state differs from what was shown before. A row whose PID now belongs to a
+// different process starts fresh instead of inheriting the old one's state.
+void carryProcessStateChanges(ProcessStore& store, const ProcessStore& previous, double now)
+{
+    unordered_map<int, int> previousRow;
+    previousRow.reserve(previous.size());
+    for (int row = 0; row < (int)previous.size(); row++) {
+        previousRow[previous.pid[row]] = row;
+    }
 
-        // Check we have enough fields
-        if (statFields.size() < 15) {
-            std::cerr << "Insufficient data in stat file for PID: " << pid << std::endl;
-            return {-1, -1};
-        }
+    store.stateChangedAt.assign(store.size(), -1.0);
+    for (size_t row = 0; row < store.size(); row++) {
+        auto it = previousRow.find(store.pid[row]);
+        if (it == previousRow.end()) continue;
 
-        // Get process CPU times
-        long utime = std::stol(statFields[13]);  // user mode time
-        long stime = std::stol(statFields[14]);  // system mode time
-        long total_time = utime + stime;
+        int prev = it->second;
+        if (prev >= (int)previous.starttime.size() || previous.starttime[prev] != store.starttime[row]) continue;
+        double changedAt = prev < (int)previous.stateChangedAt.size() ? previous.stateChangedAt[prev] : -1.0;
+        store.stateChangedAt[row] = previous.state[prev] != store.state[row] ? now : changedAt;
+    }
+}
 
-        // Get system-wide CPU times
-        std::ifstream cpuFile("/proc/stat");
-        if (!cpuFile.is_open()) {
-            std::cerr << "Could not open /proc/stat" << std::endl;
-            return {-1, -1};
-        }
+// Re-read the state of every known process, one pread per PID, and list the
+// rows whose state changed as (row, new state). The store is left untouched so
+// an unchanged table can stay shared with the previous snapshot. Exited
+// processes, and rows whose PID now belongs to a different process, keep their
+// last state until the next full scan replaces them.
+vector<pair<size_t, char>> readProcessStateChanges(const ProcessStore& store, ProcFdCache& cache)
+{
+    char buf[1024];
+    vector<pair<size_t, char>> changes;
+    Proc proc;
 
-        std::string cpuLine;
-        if (!std::getline(cpuFile, cpuLine)) {
-            std::cerr << "Failed to read from /proc/stat" << std::endl;
-            return {-1, -1};
-        }
+    for (size_t row = 0; row < store.size() && row < store.starttime.size(); row++) {
+        ssize_t len = cache.readStat(store.pid[row], buf, sizeof(buf));
+        if (len <= 0 || !parseProcStat(buf, len, proc)) continue;
+        if (proc.starttime != store.starttime[row]) continue;
 
-        // Parse CPU times from stat file
-        std::istringstream cpuStream(cpuLine);
-        std::string cpuLabel;
-        long user, nice, system, idle, iowait, irq, softirq, steal;
-        if (!(cpuStream >> cpuLabel >> user >> nice >> system >> idle >> iowait >> irq >> softirq >> steal)) {
-            std::cerr << "Failed to parse CPU data from /proc/stat" << std::endl;
-            return {-1, -1};
+        if (proc.state != store.state[row]) {
+            changes.emplace_back(row, proc.state);
         }
-        long total_system_time = user + nice + system + idle + iowait + irq + softirq + steal;
-
-        return {total_time, total_system_time};
-    };
-
-    // Take first measurement
-    auto [total_time1, system_time1] = measure();
-    if (total_time1 < 0 || system_time1 < 0) return -1.0;
-
-    // Wait 3 seconds between measurements
-    std::this_thread::sleep_for(std::chrono::milliseconds(3000));  
-
-    // Take second measurement
-    auto [total_time2, system_time2] = measure();
-    if (total_time2 < 0 || system_time2 < 0) return -1.0;
-
-    // Get system constants
-    long hertz = sysconf(_SC_CLK_TCK);
-    if (hertz <= 0) {
-        std::cerr << "Invalid clock ticks per second" << std::endl;
-        return -1.0;
-    }
-
-    long numCores = sysconf(_SC_NPROCESSORS_ONLN);
-    if (numCores <= 0) {
-        std::cerr << "Invalid number of CPU cores" << std::endl;
-        return -1.0;
     }
 
-    // Calculate time differences
-    float total_time_diff = static_cast<float>(total_time2 - total_time1) ;
-    float system_time_diff = static_cast<float>(system_time2 - system_time1) ;
+    return changes;
+}
 
-    if (system_time_diff <= 0) {
-        std::cerr << "Invalid system time difference" << std::endl;
-        return -1.0;
+void applyProcessStateChanges(ProcessStore& store, const vector<pair<size_t, char>>& changes, double now)
+{
+    store.stateChangedAt.resize(store.size(), -1.0);
+    for (const auto& change : changes) {
+        store.state[change.first] = change.second;
+        store.stateChangedAt[change.first] = now;
     }
-
-    // Calculate CPU usage percentage (total_time_diff is the process time, system_time_diff is overall CPU time)
-    float cpuUsage = 100.0 * (total_time_diff / system_time_diff);
-
-    // Multiply by the number of cores to match top's calculation
-    cpuUsage *= numCores;
-
-    return cpuUsage;
 }
@@ -1,75 +1,187 @@
 #include "header.h"
 
-// Get network interface information
-vector<NetworkInterface> getNetworkInterfaces()
+// IPv4 address of each interface that has one
+static void readInterfaceAddresses(map<string, string>& addresses)
 {
-    vector<NetworkInterface> interfaces;
+    addresses.clear();
 
-    // Get IP addresses using getifaddrs
     struct ifaddrs *ifaddr, *ifa;
     char host[NI_MAXHOST];
 
     if (getifaddrs(&ifaddr) == -1) {
-        return interfaces;
+        return;
     }
 
-    map<string, string> interfaceIPs;
-
-    // First pass: collect IP addresses
     for (ifa = ifaddr; ifa != nullptr; ifa = ifa->ifa_next) {
         if (ifa->ifa_addr == nullptr) continue;
 
-        int family = ifa->ifa_addr->sa_family;
-
-        if (family == AF_INET) {
+        if (ifa->ifa_addr->sa_family == AF_INET) {
             int s = getnameinfo(ifa->ifa_addr, sizeof(struct sockaddr_in),
                                host, NI_MAXHOST, nullptr, 0, NI_NUMERICHOST);
             if (s == 0) {
-                interfaceIPs[ifa->ifa_name] = host;
+                addresses[ifa->ifa_name] = host;
             }
         }
     }
 
     freeifaddrs(ifaddr);
+}
 
-    // Second pass: read network statistics from /proc/net/dev
-    ifstream netFile("/proc/net/dev");
-    string line;
+NetworkAddressCache::~NetworkAddressCache()
+{
+    close();
+}
 
-    // Skip header lines
-    getline(netFile, line);
-    getline(netFile, line);
+// Subscribe to link and IPv4 address changes. Returns false (and leaves the
+// cache re-reading on every refresh) when rtnetlink is not available.
+bool NetworkAddressCache::open()
+{
+    if (active()) return true;
+
+    sock = socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (sock < 0) return false;
 
-    while (getline(netFile, line)) {
-        // Parse network interface statistics
-        size_t colonPos = line.find(':');
-        if (colonPos == string::npos) continue;
+    struct sockaddr_nl addr = {};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR;
+    if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close();
+        return false;
+    }
+
+    stale = true;
+    return true;
+}
 
-        string interfaceName = line.substr(0, colonPos);
-        // Remove leading whitespace
-        interfaceName.erase(0, interfaceName.find_first_not_of(" \t"));
+void NetworkAddressCache::close()
+{
+    if (sock >= 0) {
+        ::close(sock);
+        sock = -1;
+    }
+    stale = true;
+}
 
-        string stats = line.substr(colonPos + 1);
-        istringstream iss(stats);
+void NetworkAddressCache::refresh()
+{
+    if (active()) {
+        // The contents do not matter, any link or address message means a re-read
+        alignas(struct nlmsghdr) char buf[8192];
+        while (true) {
+            ssize_t len = recv(sock, buf, sizeof(buf), 0);
+            if (len < 0) {
+                // ENOBUFS means notifications were dropped
+                if (errno == ENOBUFS) stale = true;
+                if (errno == EINTR || errno == ENOBUFS) continue;
+                break;
+            }
+            if (len > 0) stale = true;
+        }
+    }
 
-        NetworkInterface netInterface;
-        netInterface.name = interfaceName;
-        netInterface.ip = interfaceIPs[interfaceName];
+    if (stale || !active()) {
+        readInterfaceAddresses(addresses);
+        stale = false;
+    }
+}
 
-        // Parse RX stats (receive)
-        iss >> netInterface.rx.bytes >> netInterface.rx.packets
-            >> netInterface.rx.errs >> netInterface.rx.drop
-            >> netInterface.rx.fifo >> netInterface.rx.frame
-            >> netInterface.rx.compressed >> netInterface.rx.multicast;
+// Get network interface information from one read of /proc/net/dev:
+//   Inter-|   Receive                            ...|  Transmit
+//    face |bytes packets errs drop fifo frame compressed multicast|bytes packets ...
+//     eth0: 1116 12 0 0 0 0 0 0 1254 15 0 0 0 0 0 0
+// The buffer is kept between calls and only grows if the file does not fit.
+vector<NetworkInterface> getNetworkInterfaces(NetworkAddressCache* addresses)
+{
+    static vector<char> buf(16384);
+    static size_t lastCount = 0;
 
-        // Parse TX stats (transmit)
-        iss >> netInterface.tx.bytes >> netInterface.tx.packets
-            >> netInterface.tx.errs >> netInterface.tx.drop
-            >> netInterface.tx.fifo >> netInterface.tx.colls
-            >> netInterface.tx.carrier >> netInterface.tx.compressed;
+    NetworkAddressCache uncached;
+    NetworkAddressCache& cache = addresses != nullptr ? *addresses : uncached;
+    cache.refresh();
 
-        interfaces.push_back(netInterface);
+    vector<NetworkInterface> interfaces;
+    interfaces.reserve(lastCount);
+
+    ssize_t len;
+    while (true) {
+        len = readProcFile("/proc/net/dev", buf.data(), buf.size());
+        if (len < 0) return interfaces;
+        if ((size_t)len < buf.size() - 1) break;
+        buf.resize(buf.size() * 2);
     }
 
+    const char* p = buf.data();
+    const char* end = p + len;
+    for (int skip = 0; skip < 2 && p < end; skip++) {
+        const char* eol = (const char*)memchr(p, '\n', end - p);
+        p = eol != nullptr ? eol + 1 : end;
+    }
+
+    while (p < end) {
+        const char* eol = (const char*)memchr(p, '\n', end - p);
+        if (eol == nullptr) eol = end;
+
+        const char* colon = (const char*)memchr(p, ':', eol - p);
+        if (colon != nullptr) {
+            while (p < colon && *p == ' ') p++;
+
+            interfaces.emplace_back();
+            NetworkInterface& netInterface = interfaces.back();
+            netInterface.name.assign(p, colon - p);
+            auto ip = cache.addresses.find(netInterface.name);
+            if (ip != cache.addresses.end()) {
+                netInterface.ip = ip->second;
+            }
+
+            // 8 receive counters, then 8 transmit counters
+            long long fields[16] = {0};
+            const char* q = colon + 1;
+            for (int i = 0; i < 16 && q < eol; i++) {
+                while (q < eol && *q == ' ') q++;
+                q = scanNumber(q, eol, fields[i]);
+            }
+
+            netInterface.rx = {fields[0], fields[1], fields[2], fields[3],
+                               fields[4], fields[5], fields[6], fields[7]};
+            netInterface.tx = {fields[8], fields[9], fields[10], fields[11],
+                               fields[12], fields[13], fields[14], fields[15]};
+        }
+
+        p = eol + 1;
+    }
+
+    lastCount = interfaces.size();
     return interfaces;
 }
+
+// Fill in per-second rates for each interface from the previous sample of the
+// same interface. New interfaces start at zero; a zero-length interval keeps
+// the previous rates.
+void computeNetworkRates(vector<NetworkInterface>& current, const vector<NetworkInterface>& previous, double elapsed)
+{
+    for (auto& iface : current) {
+        const NetworkInterface* prev = nullptr;
+        for (const auto& candidate : previous) {
+            if (candidate.name == iface.name) {
+                prev = &candidate;
+                break;
+            }
+        }
+
+        iface.rates = NetworkRates();
+        if (prev == nullptr) continue;
+        if (elapsed <= 0.0) {
+            iface.rates = prev->rates;
+            continue;
+        }
+
+        iface.rates.rxBytes = counterDelta(prev->rx.bytes, iface.rx.bytes) / elapsed;
+        iface.rates.rxPackets = counterDelta(prev->rx.packets, iface.rx.packets) / elapsed;
+        iface.rates.rxErrs = counterDelta(prev->rx.errs, iface.rx.errs) / elapsed;
+        iface.rates.rxDrop = counterDelta(prev->rx.drop, iface.rx.drop) / elapsed;
+        iface.rates.txBytes = counterDelta(prev->tx.bytes, iface.tx.bytes) / elapsed;
+        iface.rates.txPackets = counterDelta(prev->tx.packets, iface.tx.packets) / elapsed;
+        iface.rates.txErrs = counterDelta(prev->tx.errs, iface.tx.errs) / elapsed;
+        iface.rates.txDrop = counterDelta(prev->tx.drop, iface.tx.drop) / elapsed;
+    }
+}
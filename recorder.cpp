@@ -0,0 +1,933 @@
+#include "header.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Binary snapshot log.
+//
+// Layout (integers in native byte order):
+//   header   "SMREC\0\0\1", i64 wall clock start (ms), u32 version, u32 keyframe interval
+//   record   u8 type ('K' keyframe / 'D' delta), varint time (ms, sampler clock),
+//            varint payload length, payload
+//   index    u8 'I', then one 24-byte entry per keyframe: i64 time, u64 offset, u64 record
+//   footer   u64 index offset, u64 keyframes, u64 records, i64 last time, "SMRIDX\0\1"
+//
+// A payload encodes a snapshot against a base: the previous snapshot for a
+// delta record, an empty snapshot for a keyframe. Numbers are zigzag varint
+// differences from the base, so unchanged counters cost one byte and idle
+// process rows one byte each. The filesystem, process and cgroup blocks are
+// skipped entirely while the snapshot still shares them with its base.
+// Percentages and temperatures are stored in hundredths, times in milliseconds.
+
+static const char recordMagic[8] = {'S', 'M', 'R', 'E', 'C', 0, 0, 1};
+static const char indexMagic[8] = {'S', 'M', 'R', 'I', 'D', 'X', 0, 1};
+// 2: every mounted filesystem, 3: block device I/O, 4: full meminfo, 5: pressure, 6: cgroups, 7: cpu ids,
+// 8: shared filesystem/process/cgroup blocks
+static const uint32_t recordVersion = 8;
+static const size_t recordHeaderSize = 24;
+static const size_t recordFooterSize = 40;
+static const size_t indexEntrySize = 24;
+
+// Process row flags; the top three bits hold a pid step of 1..7 when it fits
+enum {
+    rowNew = 1,       // name follows
+    rowState = 2,     // state byte follows
+    rowCPU = 4,       // cpu delta follows
+    rowRSS = 8,       // rss delta follows
+    rowChangedAt = 16 // stateChangedAt follows
+};
+
+// Counter fields in encoding order
+static long long DiskIOStats::* const diskIOFields[] = {
+    &DiskIOStats::reads, &DiskIOStats::readSectors, &DiskIOStats::readTicks, &DiskIOStats::writes,
+    &DiskIOStats::writeSectors, &DiskIOStats::writeTicks, &DiskIOStats::ioTicks,
+};
+static long long CgroupInfo::* const cgroupFields[] = {
+    &CgroupInfo::usageUsec, &CgroupInfo::userUsec, &CgroupInfo::systemUsec, &CgroupInfo::throttledUsec,
+    &CgroupInfo::memoryCurrent, &CgroupInfo::memoryAnon, &CgroupInfo::memoryFile,
+    &CgroupInfo::ioReadBytes, &CgroupInfo::ioWriteBytes,
+};
+static long long CPUStats::* const cpuFields[] = {
+    &CPUStats::user, &CPUStats::nice, &CPUStats::system, &CPUStats::idle, &CPUStats::iowait,
+    &CPUStats::irq, &CPUStats::softirq, &CPUStats::steal, &CPUStats::guest, &CPUStats::guestNice,
+};
+static unsigned long MemoryInfo::* const memoryFields[] = {
+    &MemoryInfo::totalRAM, &MemoryInfo::freeRAM, &MemoryInfo::usedRAM,
+    &MemoryInfo::totalSwap, &MemoryInfo::freeSwap, &MemoryInfo::usedSwap,
+    &MemoryInfo::availableRAM, &MemoryInfo::buffers, &MemoryInfo::cached, &MemoryInfo::swapCached,
+    &MemoryInfo::active, &MemoryInfo::inactive, &MemoryInfo::shmem, &MemoryInfo::slab,
+    &MemoryInfo::slabReclaimable, &MemoryInfo::slabUnreclaimable, &MemoryInfo::dirty, &MemoryInfo::writeback,
+    &MemoryInfo::anonPages, &MemoryInfo::mapped, &MemoryInfo::kernelStack, &MemoryInfo::pageTables,
+    &MemoryInfo::commitLimit, &MemoryInfo::committed, &MemoryInfo::anonHugePages,
+    &MemoryInfo::hugePagesTotal, &MemoryInfo::hugePagesFree, &MemoryInfo::hugePageSize,
+};
+static long long RX::* const rxFields[] = {
+    &RX::bytes, &RX::packets, &RX::errs, &RX::drop, &RX::fifo, &RX::frame, &RX::compressed, &RX::multicast,
+};
+static long long TX::* const txFields[] = {
+    &TX::bytes, &TX::packets, &TX::errs, &TX::drop, &TX::fifo, &TX::colls, &TX::carrier, &TX::compressed,
+};
+
+static long long hundredths(double value)
+{
+    return llround(value * 100.0);
+}
+
+static long long millis(double seconds)
+{
+    return llround(seconds * 1000.0);
+}
+
+static int cgroupOf(const ProcessStore& store, size_t row)
+{
+    return row < store.cgroup.size() ? store.cgroup[row] : -1;
+}
+
+struct ByteWriter {
+    vector<uint8_t>& out;
+
+    void u8(uint8_t value) { out.push_back(value); }
+
+    void varint(uint64_t value)
+    {
+        while (value >= 0x80) {
+            out.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((uint8_t)value);
+    }
+
+    void svarint(int64_t value) { varint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63)); }
+
+    void str(const string& value)
+    {
+        varint(value.size());
+        out.insert(out.end(), value.begin(), value.end());
+    }
+};
+
+// Bounds-checked reader; a truncated record leaves ok false instead of overrunning
+struct ByteReader {
+    const uint8_t* p;
+    const uint8_t* end;
+    bool ok = true;
+
+    uint8_t u8()
+    {
+        if (p >= end) {
+            ok = false;
+            return 0;
+        }
+        return *p++;
+    }
+
+    uint64_t varint()
+    {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t byte = u8();
+            value |= (uint64_t)(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        ok = false;
+        return 0;
+    }
+
+    int64_t svarint()
+    {
+        uint64_t value = varint();
+        return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+    }
+
+    // Element count; every element takes at least one byte
+    size_t count()
+    {
+        uint64_t value = varint();
+        if (value > (uint64_t)(end - p)) {
+            ok = false;
+            return 0;
+        }
+        return (size_t)value;
+    }
+
+    string str()
+    {
+        uint64_t len = varint();
+        if (len > (uint64_t)(end - p)) {
+            ok = false;
+            return string();
+        }
+        string value((const char*)p, len);
+        p += len;
+        return value;
+    }
+};
+
+// Both sides walk the snapshot in the same order. The encoder passes the
+// current snapshot's values, the decoder fills them in.
+
+static void encodeSnapshot(const SystemSnapshot& base, const SystemSnapshot& cur, vector<uint8_t>& out)
+{
+    static unordered_map<int, size_t> baseRows;
+    ByteWriter w{out};
+    long long timeMs = millis(cur.timestamp);
+
+    w.svarint((int64_t)(cur.sequence - base.sequence));
+    w.svarint(millis(cur.cpuSampledAt) - timeMs);
+    w.svarint(millis(cur.networkSampledAt) - timeMs);
+    w.svarint(millis(cur.sensorsSampledAt) - timeMs);
+    w.svarint(millis(cur.diskIOSampledAt) - timeMs);
+    w.svarint(millis(cur.pressureSampledAt) - timeMs);
+
+    const string* staticStrings[] = {&cur.osName, &cur.username, &cur.hostname, &cur.cpuModel, &cur.disk.filesystem};
+    const string* baseStrings[] = {&base.osName, &base.username, &base.hostname, &base.cpuModel, &base.disk.filesystem};
+    uint8_t changed = 0;
+    for (int i = 0; i < 5; i++) {
+        if (*staticStrings[i] != *baseStrings[i]) changed |= 1 << i;
+    }
+    w.u8(changed);
+    for (int i = 0; i < 5; i++) {
+        if (changed & (1 << i)) w.str(*staticStrings[i]);
+    }
+
+    for (auto field : cpuFields) {
+        w.svarint(cur.cpuStats.*field - base.cpuStats.*field);
+    }
+    w.svarint(hundredths(cur.cpuUsage) - hundredths(base.cpuUsage));
+    w.varint(cur.coreUsage.size());
+    for (size_t i = 0; i < cur.coreUsage.size(); i++) {
+        long long prev = i < base.coreUsage.size() ? hundredths(base.coreUsage[i]) : 0;
+        w.svarint(hundredths(cur.coreUsage[i]) - prev);
+    }
+    // CPU numbers only change when a CPU goes offline or comes back
+    bool coreIdsChanged = cur.coreIds != base.coreIds;
+    w.u8(coreIdsChanged ? 1 : 0);
+    if (coreIdsChanged) {
+        w.varint(cur.coreIds.size());
+        for (int id : cur.coreIds) w.varint(id);
+    }
+
+    for (auto field : memoryFields) {
+        w.svarint((int64_t)(cur.memory.*field - base.memory.*field));
+    }
+    w.svarint((int64_t)(cur.disk.totalDisk - base.disk.totalDisk));
+    w.svarint((int64_t)(cur.disk.freeDisk - base.disk.freeDisk));
+    w.svarint((int64_t)(cur.disk.usedDisk - base.disk.usedDisk));
+
+    // A block the sampler did not refresh is still shared with the base and
+    // costs one byte
+    bool filesystemsShared = cur.filesystems == base.filesystems;
+    w.u8(filesystemsShared ? 1 : 0);
+    if (!filesystemsShared) {
+        const vector<DiskInfo>& filesystems = *cur.filesystems;
+        const vector<DiskInfo>& baseFilesystems = *base.filesystems;
+        bool filesystemsChanged = filesystems.size() != baseFilesystems.size();
+        for (size_t i = 0; !filesystemsChanged && i < filesystems.size(); i++) {
+            filesystemsChanged = filesystems[i].mountPoint != baseFilesystems[i].mountPoint ||
+                                 filesystems[i].filesystem != baseFilesystems[i].filesystem ||
+                                 filesystems[i].fsType != baseFilesystems[i].fsType;
+        }
+        w.varint(filesystems.size());
+        w.u8(filesystemsChanged ? 1 : 0);
+        for (size_t i = 0; i < filesystems.size(); i++) {
+            const DiskInfo& disk = filesystems[i];
+            if (filesystemsChanged) {
+                w.str(disk.mountPoint);
+                w.str(disk.filesystem);
+                w.str(disk.fsType);
+            }
+            static const DiskInfo zeroDisk = {0};
+            const DiskInfo& baseDisk = i < baseFilesystems.size() ? baseFilesystems[i] : zeroDisk;
+            w.svarint((int64_t)(disk.totalDisk - baseDisk.totalDisk));
+            w.svarint((int64_t)(disk.freeDisk - baseDisk.freeDisk));
+            w.svarint((int64_t)(disk.usedDisk - baseDisk.usedDisk));
+        }
+    }
+
+    bool devicesChanged = cur.diskIO.size() != base.diskIO.size();
+    for (size_t i = 0; !devicesChanged && i < cur.diskIO.size(); i++) {
+        devicesChanged = cur.diskIO[i].name != base.diskIO[i].name;
+    }
+    w.varint(cur.diskIO.size());
+    w.u8(devicesChanged ? 1 : 0);
+    for (size_t i = 0; i < cur.diskIO.size(); i++) {
+        const DiskIOStats& device = cur.diskIO[i];
+        if (devicesChanged) w.str(device.name);
+        for (auto field : diskIOFields) {
+            w.svarint(device.*field - (i < base.diskIO.size() ? base.diskIO[i].*field : 0));
+        }
+    }
+
+    // topCounts is derived from processStates on decode
+    w.varint(cur.processStates.size());
+    for (const auto& state : cur.processStates) {
+        auto it = base.processStates.find(state.first);
+        w.u8((uint8_t)state.first);
+        w.svarint(state.second - (it != base.processStates.end() ? it->second : 0));
+    }
+    w.u8(cur.processEventsActive ? 1 : 0);
+    w.varint(cur.processForks);
+    w.varint(cur.processExits);
+
+    bool processesShared = cur.processes == base.processes;
+    w.u8(processesShared ? 1 : 0);
+    if (!processesShared) {
+        const ProcessStore& procs = *cur.processes;
+        const ProcessStore& baseProcs = *base.processes;
+        baseRows.clear();
+        for (size_t i = 0; i < baseProcs.size(); i++) baseRows[baseProcs.pid[i]] = i;
+
+        w.varint(procs.size());
+        int prevPid = 0;
+        vector<size_t> cgroupRows; // rows whose cgroup differs from the same process in the base
+        for (size_t i = 0; i < procs.size(); i++) {
+            auto it = baseRows.find(procs.pid[i]);
+            bool known = it != baseRows.end() && baseProcs.name[it->second] == procs.name[i];
+            if (cgroupOf(procs, i) != (known ? cgroupOf(baseProcs, it->second) : -1)) cgroupRows.push_back(i);
+            char baseState = known ? baseProcs.state[it->second] : 0;
+            long long baseCPUUsage = known ? hundredths(baseProcs.cpu[it->second]) : 0;
+            long long baseRSS = known ? baseProcs.rss[it->second] : 0;
+            long long baseChangedAt = known ? millis(baseProcs.stateChangedAt[it->second]) : millis(-1.0);
+
+            uint8_t flags = 0;
+            if (!known) flags |= rowNew;
+            if (procs.state[i] != baseState) flags |= rowState;
+            if (hundredths(procs.cpu[i]) != baseCPUUsage) flags |= rowCPU;
+            if (procs.rss[i] != baseRSS) flags |= rowRSS;
+            if (millis(procs.stateChangedAt[i]) != baseChangedAt) flags |= rowChangedAt;
+
+            int step = procs.pid[i] - prevPid;
+            if (step >= 1 && step <= 7) flags |= step << 5;
+            w.u8(flags);
+            if (!(flags >> 5)) w.svarint(step);
+            prevPid = procs.pid[i];
+
+            if (flags & rowNew) w.str(procs.name[i]);
+            if (flags & rowState) w.u8((uint8_t)procs.state[i]);
+            if (flags & rowCPU) w.svarint(hundredths(procs.cpu[i]) - baseCPUUsage);
+            if (flags & rowRSS) w.svarint(procs.rss[i] - baseRSS);
+            if (flags & rowChangedAt) w.svarint(millis(procs.stateChangedAt[i]) - timeMs);
+        }
+
+        w.varint(cgroupRows.size());
+        size_t prevRow = 0;
+        for (size_t row : cgroupRows) {
+            w.varint(row - prevRow);
+            w.svarint(cgroupOf(procs, row));
+            prevRow = row;
+        }
+    }
+
+    // Paths are only written when the cgroup list changes; rollups and rates are derived on decode
+    bool cgroupsShared = cur.cgroups == base.cgroups;
+    w.u8(cgroupsShared ? 1 : 0);
+    if (!cgroupsShared) {
+        const vector<CgroupInfo>& cgroups = *cur.cgroups;
+        const vector<CgroupInfo>& baseCgroups = *base.cgroups;
+        bool cgroupsChanged = cgroups.size() != baseCgroups.size();
+        for (size_t i = 0; !cgroupsChanged && i < cgroups.size(); i++) {
+            cgroupsChanged = cgroups[i].path != baseCgroups[i].path;
+        }
+        w.svarint(millis(cur.cgroupsSampledAt) - timeMs);
+        w.varint(cgroups.size());
+        w.u8(cgroupsChanged ? 1 : 0);
+        for (size_t i = 0; i < cgroups.size(); i++) {
+            static const CgroupInfo none;
+            const CgroupInfo& cgroup = cgroups[i];
+            const CgroupInfo& prev = i < baseCgroups.size() ? baseCgroups[i] : none;
+            if (cgroupsChanged) {
+                w.str(cgroup.path);
+                w.varint(cgroup.parent + 1);
+            }
+            w.u8(cgroup.populated ? 1 : 0);
+            for (auto field : cgroupFields) w.svarint(cgroup.*field - prev.*field);
+        }
+    }
+
+    // Names and addresses are only written when the interface list changes
+    bool interfacesChanged = cur.interfaces.size() != base.interfaces.size();
+    for (size_t i = 0; !interfacesChanged && i < cur.interfaces.size(); i++) {
+        interfacesChanged = cur.interfaces[i].name != base.interfaces[i].name ||
+                            cur.interfaces[i].ip != base.interfaces[i].ip;
+    }
+    w.varint(cur.interfaces.size());
+    w.u8(interfacesChanged ? 1 : 0);
+    for (size_t i = 0; i < cur.interfaces.size(); i++) {
+        const NetworkInterface& iface = cur.interfaces[i];
+        if (interfacesChanged) {
+            w.str(iface.name);
+            w.str(iface.ip);
+        }
+        static const RX zeroRX = {0};
+        static const TX zeroTX = {0};
+        const RX& baseRX = i < base.interfaces.size() ? base.interfaces[i].rx : zeroRX;
+        const TX& baseTX = i < base.interfaces.size() ? base.interfaces[i].tx : zeroTX;
+        for (auto field : rxFields) w.svarint(iface.rx.*field - baseRX.*field);
+        for (auto field : txFields) w.svarint(iface.tx.*field - baseTX.*field);
+    }
+
+    bool thermalChanged = cur.thermal.size() != base.thermal.size();
+    for (size_t i = 0; !thermalChanged && i < cur.thermal.size(); i++) {
+        thermalChanged = cur.thermal[i].label != base.thermal[i].label;
+    }
+    w.varint(cur.thermal.size());
+    w.u8(thermalChanged ? 1 : 0);
+    for (size_t i = 0; i < cur.thermal.size(); i++) {
+        if (thermalChanged) w.str(cur.thermal[i].label);
+        long long prev = i < base.thermal.size() ? hundredths(base.thermal[i].temperature) : 0;
+        w.svarint(hundredths(cur.thermal[i].temperature) - prev);
+    }
+
+    bool fansChanged = cur.fans.size() != base.fans.size();
+    for (size_t i = 0; !fansChanged && i < cur.fans.size(); i++) {
+        fansChanged = cur.fans[i].label != base.fans[i].label;
+    }
+    w.varint(cur.fans.size());
+    w.u8(fansChanged ? 1 : 0);
+    for (size_t i = 0; i < cur.fans.size(); i++) {
+        if (fansChanged) w.str(cur.fans[i].label);
+        w.svarint(cur.fans[i].speed - (i < base.fans.size() ? base.fans[i].speed : 0));
+    }
+
+    w.varint(cur.pressure.size());
+    for (size_t i = 0; i < cur.pressure.size(); i++) {
+        static const PressureInfo none;
+        const PressureInfo& info = cur.pressure[i];
+        const PressureInfo& prev = i < base.pressure.size() ? base.pressure[i] : none;
+        w.str(info.resource);
+        w.u8(info.hasFull ? 1 : 0);
+        for (auto line : {&PressureInfo::some, &PressureInfo::full}) {
+            w.svarint(hundredths((info.*line).avg10) - hundredths((prev.*line).avg10));
+            w.svarint(hundredths((info.*line).avg60) - hundredths((prev.*line).avg60));
+            w.svarint(hundredths((info.*line).avg300) - hundredths((prev.*line).avg300));
+            w.svarint((int64_t)((info.*line).total - (prev.*line).total));
+        }
+    }
+    w.u8(cur.pressureTriggersActive ? 1 : 0);
+    w.varint(cur.pressureStalls);
+}
+
+static bool decodeSnapshot(const SystemSnapshot& base, long long timeMs, ByteReader& r, SystemSnapshot& cur)
+{
+    static unordered_map<int, size_t> baseRows;
+
+    cur.timestamp = timeMs / 1000.0;
+    cur.sequence = base.sequence + r.svarint();
+    cur.cpuSampledAt = (timeMs + r.svarint()) / 1000.0;
+    cur.networkSampledAt = (timeMs + r.svarint()) / 1000.0;
+    cur.sensorsSampledAt = (timeMs + r.svarint()) / 1000.0;
+    cur.diskIOSampledAt = (timeMs + r.svarint()) / 1000.0;
+    cur.pressureSampledAt = (timeMs + r.svarint()) / 1000.0;
+
+    string* staticStrings[] = {&cur.osName, &cur.username, &cur.hostname, &cur.cpuModel, &cur.disk.filesystem};
+    const string* baseStrings[] = {&base.osName, &base.username, &base.hostname, &base.cpuModel, &base.disk.filesystem};
+    uint8_t changed = r.u8();
+    for (int i = 0; i < 5; i++) {
+        *staticStrings[i] = (changed & (1 << i)) ? r.str() : *baseStrings[i];
+    }
+
+    for (auto field : cpuFields) {
+        cur.cpuStats.*field = base.cpuStats.*field + r.svarint();
+    }
+    cur.cpuUsage = (hundredths(base.cpuUsage) + r.svarint()) / 100.0;
+    cur.coreUsage.resize(r.count());
+    for (size_t i = 0; i < cur.coreUsage.size(); i++) {
+        long long prev = i < base.coreUsage.size() ? hundredths(base.coreUsage[i]) : 0;
+        cur.coreUsage[i] = (prev + r.svarint()) / 100.0f;
+    }
+    if (r.u8()) {
+        cur.coreIds.resize(r.count());
+        for (size_t i = 0; i < cur.coreIds.size(); i++) cur.coreIds[i] = (int)r.varint();
+    } else {
+        cur.coreIds = base.coreIds;
+    }
+
+    for (auto field : memoryFields) {
+        cur.memory.*field = base.memory.*field + r.svarint();
+    }
+    cur.disk.totalDisk = base.disk.totalDisk + r.svarint();
+    cur.disk.freeDisk = base.disk.freeDisk + r.svarint();
+    cur.disk.usedDisk = base.disk.usedDisk + r.svarint();
+
+    if (r.u8()) {
+        cur.filesystems = base.filesystems;
+    } else {
+        const vector<DiskInfo>& baseFilesystems = *base.filesystems;
+        auto filesystems = make_shared<vector<DiskInfo>>(r.count());
+        bool filesystemsChanged = r.u8() != 0;
+        if (!filesystemsChanged && filesystems->size() != baseFilesystems.size()) return false;
+        for (size_t i = 0; i < filesystems->size(); i++) {
+            DiskInfo& disk = (*filesystems)[i];
+            static const DiskInfo zeroDisk = {0};
+            const DiskInfo& baseDisk = i < baseFilesystems.size() ? baseFilesystems[i] : zeroDisk;
+            if (filesystemsChanged) {
+                disk.mountPoint = r.str();
+                disk.filesystem = r.str();
+                disk.fsType = r.str();
+            } else {
+                disk.mountPoint = baseDisk.mountPoint;
+                disk.filesystem = baseDisk.filesystem;
+                disk.fsType = baseDisk.fsType;
+            }
+            disk.totalDisk = baseDisk.totalDisk + r.svarint();
+            disk.freeDisk = baseDisk.freeDisk + r.svarint();
+            disk.usedDisk = baseDisk.usedDisk + r.svarint();
+        }
+        cur.filesystems = filesystems;
+    }
+    cur.diskIO.resize(r.count());
+    bool devicesChanged = r.u8() != 0;
+    if (!devicesChanged && cur.diskIO.size() != base.diskIO.size()) return false;
+    for (size_t i = 0; i < cur.diskIO.size(); i++) {
+        DiskIOStats& device = cur.diskIO[i];
+        device.name = devicesChanged ? r.str() : base.diskIO[i].name;
+        for (auto field : diskIOFields) {
+            device.*field = (i < base.diskIO.size() ? base.diskIO[i].*field : 0) + r.svarint();
+        }
+    }
+    computeDiskIORates(cur.diskIO, base.diskIO, cur.diskIOSampledAt - base.diskIOSampledAt);
+
+    const vector<DiskInfo>& filesystems = *cur.filesystems;
+    if (!filesystems.empty() && filesystems[0].mountPoint == "/") {
+        cur.disk.mountPoint = filesystems[0].mountPoint;
+        cur.disk.fsType = filesystems[0].fsType;
+    }
+
+    cur.processStates.clear();
+    for (size_t n = r.count(); n > 0 && r.ok; n--) {
+        char state = (char)r.u8();
+        auto it = base.processStates.find(state);
+        cur.processStates[state] = (it != base.processStates.end() ? it->second : 0) + (int)r.svarint();
+    }
+    cur.topCounts = summarizeProcessStates(cur.processStates);
+    cur.processEventsActive = r.u8() != 0;
+    cur.processForks = r.varint();
+    cur.processExits = r.varint();
+
+    if (r.u8()) {
+        cur.processes = base.processes;
+    } else {
+        const ProcessStore& baseProcs = *base.processes;
+        baseRows.clear();
+        for (size_t i = 0; i < baseProcs.size(); i++) baseRows[baseProcs.pid[i]] = i;
+
+        auto store = make_shared<ProcessStore>();
+        ProcessStore& procs = *store;
+        size_t count = r.count();
+        procs.pid.resize(count);
+        procs.name.resize(count);
+        procs.state.resize(count);
+        procs.cpu.resize(count);
+        procs.rss.resize(count);
+        procs.stateChangedAt.resize(count);
+        procs.cgroup.resize(count);
+
+        int prevPid = 0;
+        for (size_t i = 0; i < count && r.ok; i++) {
+            uint8_t flags = r.u8();
+            int step = flags >> 5;
+            int pid = prevPid + (step ? step : (int)r.svarint());
+            prevPid = pid;
+
+            auto it = (flags & rowNew) ? baseRows.end() : baseRows.find(pid);
+            bool known = it != baseRows.end();
+            if (!(flags & rowNew) && !known) return false;
+
+            procs.pid[i] = pid;
+            procs.name[i] = known ? baseProcs.name[it->second] : r.str();
+            char baseState = known ? baseProcs.state[it->second] : 0;
+            long long baseCPUUsage = known ? hundredths(baseProcs.cpu[it->second]) : 0;
+            long long baseRSS = known ? baseProcs.rss[it->second] : 0;
+            double baseChangedAt = known ? baseProcs.stateChangedAt[it->second] : -1.0;
+
+            procs.state[i] = (flags & rowState) ? (char)r.u8() : baseState;
+            procs.cpu[i] = (baseCPUUsage + ((flags & rowCPU) ? r.svarint() : 0)) / 100.0f;
+            procs.rss[i] = baseRSS + ((flags & rowRSS) ? r.svarint() : 0);
+            procs.stateChangedAt[i] = (flags & rowChangedAt) ? (timeMs + r.svarint()) / 1000.0 : baseChangedAt;
+            procs.cgroup[i] = known ? cgroupOf(baseProcs, it->second) : -1;
+        }
+        size_t row = 0;
+        for (size_t n = r.count(); n > 0 && r.ok; n--) {
+            row += r.varint();
+            int cgroup = (int)r.svarint();
+            if (row >= count) return false;
+            procs.cgroup[row] = cgroup;
+        }
+        computeProcessMemoryUsage(procs, cur.memory.totalRAM);
+        cur.processes = store;
+    }
+
+    if (r.u8()) {
+        cur.cgroups = base.cgroups;
+        cur.cgroupsSampledAt = base.cgroupsSampledAt;
+    } else {
+        const vector<CgroupInfo>& baseCgroups = *base.cgroups;
+        cur.cgroupsSampledAt = (timeMs + r.svarint()) / 1000.0;
+        auto cgroups = make_shared<vector<CgroupInfo>>(r.count());
+        bool cgroupsChanged = r.u8() != 0;
+        if (!cgroupsChanged && cgroups->size() != baseCgroups.size()) return false;
+        for (size_t i = 0; i < cgroups->size(); i++) {
+            static const CgroupInfo none;
+            CgroupInfo& cgroup = (*cgroups)[i];
+            const CgroupInfo& prev = i < baseCgroups.size() ? baseCgroups[i] : none;
+            if (cgroupsChanged) {
+                cgroup.path = r.str();
+                cgroup.parent = (int)r.varint() - 1;
+                if (cgroup.parent < -1 || cgroup.parent >= (int)i) return false;
+            } else {
+                cgroup.path = prev.path;
+                cgroup.parent = prev.parent;
+            }
+            cgroup.populated = r.u8() != 0;
+            for (auto field : cgroupFields) cgroup.*field = prev.*field + r.svarint();
+        }
+        computeCgroupRates(*cgroups, baseCgroups, cur.cgroupsSampledAt - base.cgroupsSampledAt);
+        rollUpCgroups(*cgroups, *cur.processes);
+        cur.cgroups = cgroups;
+    }
+
+    // Rows and cgroups decode separately, so indices are checked once both are known
+    const vector<int>& rowCgroups = cur.processes->cgroup;
+    for (int cgroup : rowCgroups) {
+        if (cgroup < -1 || cgroup >= (int)cur.cgroups->size()) return false;
+    }
+
+    cur.interfaces.resize(r.count());
+    bool interfacesChanged = r.u8() != 0;
+    if (!interfacesChanged && cur.interfaces.size() != base.interfaces.size()) return false;
+    for (size_t i = 0; i < cur.interfaces.size(); i++) {
+        NetworkInterface& iface = cur.interfaces[i];
+        if (interfacesChanged) {
+            iface.name = r.str();
+            iface.ip = r.str();
+        } else {
+            iface.name = base.interfaces[i].name;
+            iface.ip = base.interfaces[i].ip;
+        }
+        static const RX zeroRX = {0};
+        static const TX zeroTX = {0};
+        const RX& baseRX = i < base.interfaces.size() ? base.interfaces[i].rx : zeroRX;
+        const TX& baseTX = i < base.interfaces.size() ? base.interfaces[i].tx : zeroTX;
+        for (auto field : rxFields) iface.rx.*field = baseRX.*field + r.svarint();
+        for (auto field : txFields) iface.tx.*field = baseTX.*field + r.svarint();
+    }
+    // Rates are derived, not stored; a keyframe has no base and starts at zero
+    computeNetworkRates(cur.interfaces, base.interfaces, cur.networkSampledAt - base.networkSampledAt);
+
+    cur.thermal.resize(r.count());
+    bool thermalChanged = r.u8() != 0;
+    if (!thermalChanged && cur.thermal.size() != base.thermal.size()) return false;
+    for (size_t i = 0; i < cur.thermal.size(); i++) {
+        cur.thermal[i].label = thermalChanged ? r.str() : base.thermal[i].label;
+        long long prev = i < base.thermal.size() ? hundredths(base.thermal[i].temperature) : 0;
+        cur.thermal[i].temperature = (prev + r.svarint()) / 100.0;
+    }
+
+    cur.fans.resize(r.count());
+    bool fansChanged = r.u8() != 0;
+    if (!fansChanged && cur.fans.size() != base.fans.size()) return false;
+    for (size_t i = 0; i < cur.fans.size(); i++) {
+        cur.fans[i].label = fansChanged ? r.str() : base.fans[i].label;
+        cur.fans[i].speed = (i < base.fans.size() ? base.fans[i].speed : 0) + (int)r.svarint();
+    }
+
+
+    cur.pressure.resize(r.count());
+    for (size_t i = 0; i < cur.pressure.size(); i++) {
+        static const PressureInfo none;
+        PressureInfo& info = cur.pressure[i];
+        const PressureInfo& prev = i < base.pressure.size() ? base.pressure[i] : none;
+        info.resource = r.str();
+        info.hasFull = r.u8() != 0;
+        for (auto line : {&PressureInfo::some, &PressureInfo::full}) {
+            (info.*line).avg10 = (hundredths((prev.*line).avg10) + r.svarint()) / 100.0;
+            (info.*line).avg60 = (hundredths((prev.*line).avg60) + r.svarint()) / 100.0;
+            (info.*line).avg300 = (hundredths((prev.*line).avg300) + r.svarint()) / 100.0;
+            (info.*line).total = (prev.*line).total + r.svarint();
+        }
+    }
+    cur.pressureTriggersActive = r.u8() != 0;
+    cur.pressureStalls = r.varint();
+    return r.ok;
+}
+
+SnapshotRecorder::~SnapshotRecorder()
+{
+    close();
+}
+
+bool SnapshotRecorder::open(const string& path)
+{
+    close();
+
+    file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        fprintf(stderr, "Recorder: cannot open %s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    char header[recordHeaderSize];
+    int64_t wallStart = chrono::duration_cast<chrono::milliseconds>(
+        chrono::system_clock::now().time_since_epoch()).count();
+    uint32_t interval = recordKeyframeInterval;
+    memcpy(header, recordMagic, 8);
+    memcpy(header + 8, &wallStart, 8);
+    memcpy(header + 16, &recordVersion, 4);
+    memcpy(header + 20, &interval, 4);
+    fwrite(header, 1, sizeof(header), file);
+
+    offset = recordHeaderSize;
+    records = 0;
+    lastTimeMs = 0;
+    keyframes.clear();
+    previous.reset();
+    return true;
+}
+
+void SnapshotRecorder::append(const shared_ptr<const SystemSnapshot>& snapshot)
+{
+    if (file == nullptr || !snapshot) return;
+
+    static const SystemSnapshot empty;
+    bool keyframe = !previous || records % recordKeyframeInterval == 0;
+    long long timeMs = millis(snapshot->timestamp);
+
+    payload.clear();
+    encodeSnapshot(keyframe ? empty : *previous, *snapshot, payload);
+
+    if (keyframe) {
+        keyframes.push_back({timeMs, offset, records});
+    }
+
+    frame.clear();
+    ByteWriter w{frame};
+    w.u8(keyframe ? 'K' : 'D');
+    w.varint((uint64_t)timeMs);
+    w.varint(payload.size());
+
+    fwrite(frame.data(), 1, frame.size(), file);
+    fwrite(payload.data(), 1, payload.size(), file);
+    offset += frame.size() + payload.size();
+    records++;
+    lastTimeMs = timeMs;
+    previous = snapshot;
+}
+
+void SnapshotRecorder::close()
+{
+    if (file == nullptr) return;
+
+    // Keyframe index and footer, so replay can seek without scanning
+    uint64_t indexOffset = offset + 1;
+    fputc('I', file);
+    for (const auto& entry : keyframes) {
+        char raw[indexEntrySize];
+        memcpy(raw, &entry.timeMs, 8);
+        memcpy(raw + 8, &entry.offset, 8);
+        memcpy(raw + 16, &entry.record, 8);
+        fwrite(raw, 1, sizeof(raw), file);
+    }
+
+    char footer[recordFooterSize];
+    uint64_t keyframeCount = keyframes.size();
+    int64_t lastTime = lastTimeMs;
+    memcpy(footer, &indexOffset, 8);
+    memcpy(footer + 8, &keyframeCount, 8);
+    memcpy(footer + 16, &records, 8);
+    memcpy(footer + 24, &lastTime, 8);
+    memcpy(footer + 32, indexMagic, 8);
+    fwrite(footer, 1, sizeof(footer), file);
+
+    fclose(file);
+    file = nullptr;
+    previous.reset();
+}
+
+SnapshotReplay::~SnapshotReplay()
+{
+    if (data != nullptr) munmap((void*)data, size);
+}
+
+bool SnapshotReplay::open(const string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "Replay: cannot open %s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < recordHeaderSize) {
+        fprintf(stderr, "Replay: %s is not a recording\n", path.c_str());
+        ::close(fd);
+        return false;
+    }
+
+    size = st.st_size;
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        fprintf(stderr, "Replay: cannot map %s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    data = (const uint8_t*)mapped;
+
+    uint32_t version = 0;
+    memcpy(&version, data + 16, 4);
+    if (memcmp(data, recordMagic, 8) != 0 || version != recordVersion) {
+        fprintf(stderr, "Replay: %s is not a version %u recording\n", path.c_str(), recordVersion);
+        return false;
+    }
+    memcpy(&wallClockStartMs, data + 8, 8);
+
+    // The index is read in place from the mapping. A log cut short (crash,
+    // still recording) has no footer and gets its keyframes rebuilt by one
+    // pass over the record headers.
+    bool indexed = false;
+    if (size >= recordHeaderSize + recordFooterSize &&
+        memcmp(data + size - 8, indexMagic, 8) == 0) {
+        const uint8_t* footer = data + size - recordFooterSize;
+        uint64_t indexOffset;
+        memcpy(&indexOffset, footer, 8);
+        memcpy(&keyframeCount, footer + 8, 8);
+        memcpy(&records, footer + 16, 8);
+        memcpy(&lastTimeMs, footer + 24, 8);
+        if (indexOffset + keyframeCount * indexEntrySize == size - recordFooterSize) {
+            index = data + indexOffset;
+            indexed = true;
+        }
+    }
+
+    if (!indexed) {
+        rebuiltIndex.clear();
+        records = 0;
+        for (size_t at = recordHeaderSize; at < size;) {
+            ByteReader r{data + at, data + size};
+            uint8_t type = r.u8();
+            long long timeMs = (long long)r.varint();
+            uint64_t len = r.varint();
+            if (!r.ok || (type != 'K' && type != 'D') || len > (uint64_t)(r.end - r.p)) break;
+
+            if (type == 'K') {
+                char raw[indexEntrySize];
+                int64_t time = timeMs;
+                uint64_t offset = at;
+                memcpy(raw, &time, 8);
+                memcpy(raw + 8, &offset, 8);
+                memcpy(raw + 16, &records, 8);
+                rebuiltIndex.insert(rebuiltIndex.end(), raw, raw + sizeof(raw));
+            }
+            records++;
+            lastTimeMs = timeMs;
+            at = (r.p - data) + len;
+        }
+        keyframeCount = rebuiltIndex.size() / indexEntrySize;
+        index = rebuiltIndex.data();
+    }
+
+    if (keyframeCount == 0) {
+        fprintf(stderr, "Replay: %s has no snapshots\n", path.c_str());
+        return false;
+    }
+    return seek(startTime()) != nullptr;
+}
+
+SnapshotReplay::IndexEntry SnapshotReplay::keyframe(size_t i) const
+{
+    IndexEntry entry;
+    memcpy(&entry.timeMs, index + i * indexEntrySize, 8);
+    memcpy(&entry.offset, index + i * indexEntrySize + 8, 8);
+    memcpy(&entry.record, index + i * indexEntrySize + 16, 8);
+    return entry;
+}
+
+double SnapshotReplay::startTime() const
+{
+    return keyframeCount ? keyframe(0).timeMs / 1000.0 : 0.0;
+}
+
+double SnapshotReplay::endTime() const
+{
+    return lastTimeMs / 1000.0;
+}
+
+// Decode the record at nextOffset on top of the current snapshot
+bool SnapshotReplay::decodeNext(bool fromKeyframe)
+{
+    static const SystemSnapshot empty;
+
+    ByteReader r{data + nextOffset, data + size};
+    uint8_t type = r.u8();
+    long long timeMs = (long long)r.varint();
+    uint64_t len = r.varint();
+    if (!r.ok || len > (uint64_t)(r.end - r.p)) return false;
+    if (type != 'K' && !(type == 'D' && !fromKeyframe && currentSnapshot)) return false;
+
+    ByteReader body{r.p, r.p + len};
+    auto next = make_shared<SystemSnapshot>();
+    const SystemSnapshot& base = type == 'K' ? empty : *currentSnapshot;
+    if (!decodeSnapshot(base, timeMs, body, *next)) return false;
+
+    currentSnapshot = next;
+    currentRecord = fromKeyframe ? currentRecord : currentRecord + 1;
+    nextOffset = (r.p - data) + len;
+    return true;
+}
+
+// Time of the record at nextOffset, or -1 at the end of the log
+long long SnapshotReplay::peekTime() const
+{
+    if (currentRecord + 1 >= records) return -1;
+    ByteReader r{data + nextOffset, data + size};
+    uint8_t type = r.u8();
+    long long timeMs = (long long)r.varint();
+    return r.ok && (type == 'K' || type == 'D') ? timeMs : -1;
+}
+
+shared_ptr<const SystemSnapshot> SnapshotReplay::seek(double time)
+{
+    long long target = millis(time);
+
+    // Last keyframe at or before the target
+    size_t lo = 0;
+    size_t hi = keyframeCount;
+    while (hi - lo > 1) {
+        size_t mid = (lo + hi) / 2;
+        if (keyframe(mid).timeMs <= target) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    // Playing forward inside one keyframe span keeps decoding from where it is
+    bool sameSpan = currentSnapshot && currentKeyframe == lo && millis(currentSnapshot->timestamp) <= target;
+    if (!sameSpan) {
+        IndexEntry entry = keyframe(lo);
+        shared_ptr<const SystemSnapshot> previous = currentSnapshot;
+        bool follows = previous && entry.record == currentRecord + 1;
+        nextOffset = entry.offset;
+        currentRecord = entry.record;
+        currentKeyframe = lo;
+        if (!decodeNext(true)) return nullptr;
+
+        // Playing across a keyframe still has the record before it for rates
+        if (follows) {
+            computeNetworkRates(currentSnapshot->interfaces, previous->interfaces,
+                                currentSnapshot->networkSampledAt - previous->networkSampledAt);
+            computeDiskIORates(currentSnapshot->diskIO, previous->diskIO,
+                               currentSnapshot->diskIOSampledAt - previous->diskIOSampledAt);
+            auto cgroups = make_shared<vector<CgroupInfo>>(*currentSnapshot->cgroups);
+            computeCgroupRates(*cgroups, *previous->cgroups,
+                               currentSnapshot->cgroupsSampledAt - previous->cgroupsSampledAt);
+            currentSnapshot->cgroups = cgroups;
+        }
+    }
+
+    size_t nextKeyframeRecord = lo + 1 < keyframeCount ? keyframe(lo + 1).record : records;
+    while (currentRecord + 1 < nextKeyframeRecord) {
+        long long nextTime = peekTime();
+        if (nextTime < 0 || nextTime > target) break;
+        if (!decodeNext(false)) break;
+    }
+    return currentSnapshot;
+}
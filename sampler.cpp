@@ -0,0 +1,306 @@
+#include "header.h"
+
+// Collector thread state. The latest snapshot is swapped in atomically so the
+// render thread never waits on a /proc read.
+static thread samplerThread;
+static mutex samplerMutex;
+static condition_variable samplerWake;
+static bool samplerStop = false;
+static bool samplerPressureStall = false; // set by the PSI trigger watcher
+static shared_ptr<const SystemSnapshot> latestSnapshot = make_shared<SystemSnapshot>();
+
+// Tracks when each collector last ran
+struct SamplerSchedule {
+    double lastCPU = -1e9;
+    double lastMemory = -1e9;
+    double lastDisk = -1e9;
+    double lastDiskIO = -1e9;
+    double lastProcesses = -1e9;
+    double lastStates = -1e9;
+    double lastNetwork = -1e9;
+    double lastSensors = -1e9;
+    double lastPressure = -1e9;
+    double lastStatic = -1e9;
+};
+
+// Everything the collectors keep between ticks, owned by the sampler thread
+struct SamplerState {
+    SamplerSchedule schedule;
+    ProcessCPUSampler processCPU;
+    ProcFdCache fdCache;
+    ProcEventListener procEvents;
+    NetworkAddressCache networkAddresses;
+    MountTable mounts;
+    CgroupTree cgroups;
+    SnapshotRecorder recorder;
+    PressureTriggers pressureTriggers;
+    CPUStats prevCPU = {0};
+    CoreStats prevCores;
+
+    explicit SamplerState(const SamplerConfig& config) : fdCache(config.procFdBudget)
+    {
+        processCPU.numCores = max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+
+        // Falls back to the plain readdir scan when the proc connector is not permitted
+        if (config.useProcEvents) {
+            procEvents.open();
+        }
+
+        // Falls back to re-reading addresses every sample without rtnetlink
+        networkAddresses.open();
+        mounts.open();
+
+        // Falls back to re-walking the cgroup hierarchy on every scan without inotify
+        cgroups.open();
+
+        if (!config.recordPath.empty()) {
+            recorder.open(config.recordPath);
+        }
+
+        // Falls back to plain polling on pressureInterval when triggers are refused
+        if (config.usePressureTriggers) {
+            pressureTriggers.open(config.pressureStallUs, config.pressureWindowUs, []() {
+                lock_guard<mutex> lock(samplerMutex);
+                samplerPressureStall = true;
+                samplerWake.notify_all();
+            });
+        }
+    }
+};
+
+// Run every collector that is due and return the next snapshot, or nullptr if
+// nothing was due. The previous snapshot is copied so untouched fields carry over;
+// the process table, cgroups and filesystems are shared rather than copied.
+// A PSI trigger refreshes pressure straight away without shifting its schedule.
+static shared_ptr<SystemSnapshot> collectDue(const SamplerConfig& config, SamplerState& state, double now,
+                                             bool pressureStall = false)
+{
+    SamplerSchedule& schedule = state.schedule;
+    auto due = [now](double last, double interval) { return now - last >= interval; };
+
+    bool cpuDue = due(schedule.lastCPU, config.cpuInterval);
+    bool memoryDue = due(schedule.lastMemory, config.memoryInterval);
+    bool diskDue = due(schedule.lastDisk, config.diskInterval);
+    bool diskIODue = due(schedule.lastDiskIO, config.diskIOInterval);
+    bool processesDue = due(schedule.lastProcesses, config.processInterval);
+    bool statesDue = !processesDue && due(schedule.lastStates, config.stateInterval);
+    bool networkDue = due(schedule.lastNetwork, config.networkInterval);
+    bool sensorsDue = due(schedule.lastSensors, config.sensorInterval);
+    bool pressureDue = due(schedule.lastPressure, config.pressureInterval);
+    bool staticDue = due(schedule.lastStatic, config.staticInterval);
+
+    if (!(cpuDue || memoryDue || diskDue || diskIODue || processesDue || statesDue || networkDue || sensorsDue ||
+          pressureDue || pressureStall || staticDue)) {
+        return nullptr;
+    }
+
+    auto snapshot = make_shared<SystemSnapshot>(*getLatestSnapshot());
+    snapshot->sequence++;
+    snapshot->timestamp = now;
+
+    if (staticDue) {
+        snapshot->osName = getOsName();
+        snapshot->username = getUsername();
+        snapshot->hostname = getHostname();
+        snapshot->cpuModel = CPUinfo();
+        schedule.lastStatic = now;
+    }
+
+    if (cpuDue) {
+        // Aggregate and per-core rows come from the same read of /proc/stat
+        CPUStats total;
+        CoreStats cores;
+        if (readCPUStats(total, cores)) {
+            snapshot->cpuStats = total;
+            snapshot->cpuUsage = cpuUsageBetween(state.prevCPU, total);
+            computeCoreUsage(state.prevCores, cores, snapshot->coreUsage);
+            snapshot->coreIds = cores.ids;
+            state.prevCPU = total;
+            state.prevCores = move(cores);
+        }
+        snapshot->cpuSampledAt = now;
+        schedule.lastCPU = now;
+    }
+
+    if (memoryDue) {
+        snapshot->memory = getMemoryInfo();
+        schedule.lastMemory = now;
+    }
+
+    if (diskDue) {
+        auto filesystems = make_shared<vector<DiskInfo>>(getFilesystemUsage(state.mounts));
+        snapshot->disk = DiskInfo();
+        if (!filesystems->empty() && (*filesystems)[0].mountPoint == "/") {
+            snapshot->disk = (*filesystems)[0];
+        }
+        snapshot->filesystems = move(filesystems);
+        schedule.lastDisk = now;
+    }
+
+    if (diskIODue) {
+        // The copied snapshot still holds the previous sample to diff against
+        vector<DiskIOStats> devices = getDiskIOStats();
+        computeDiskIORates(devices, snapshot->diskIO, now - snapshot->diskIOSampledAt);
+        snapshot->diskIO = move(devices);
+        snapshot->diskIOSampledAt = now;
+        schedule.lastDiskIO = now;
+    }
+
+    if (processesDue) {
+        // One /proc walk feeds the process table and the task overview
+        ProcessScan scan = scanProcesses(&state.fdCache, &state.procEvents);
+        map<int, float> cpuUsage = state.processCPU.update(scan.processes, getCPUStats());
+        auto store = make_shared<ProcessStore>(buildProcessStore(scan.processes, cpuUsage));
+        computeProcessMemoryUsage(*store, snapshot->memory.totalRAM);
+        carryProcessStateChanges(*store, *snapshot->processes, now);
+
+        // cgroups are read alongside the process table so the rollups add up
+        state.cgroups.refresh();
+        auto cgroups = make_shared<vector<CgroupInfo>>(state.cgroups.collect());
+        computeCgroupRates(*cgroups, *snapshot->cgroups, now - snapshot->cgroupsSampledAt);
+        state.cgroups.assignProcesses(scan.processes, *cgroups, *store);
+        rollUpCgroups(*cgroups, *store);
+        snapshot->cgroups = move(cgroups);
+        snapshot->cgroupsSampledAt = now;
+
+        snapshot->processes = move(store);
+        snapshot->processStates = move(scan.stateCounts);
+        snapshot->topCounts = move(scan.topCounts);
+        snapshot->processEventsActive = scan.eventDriven;
+        snapshot->processForks = scan.forks;
+        snapshot->processExits = scan.exits;
+        schedule.lastProcesses = now;
+        schedule.lastStates = now;
+    }
+
+    // Between full scans only the State column is refreshed, so the table and
+    // the task overview follow state changes at the faster rate. The table is
+    // only copied when a state actually changed.
+    if (statesDue) {
+        vector<pair<size_t, char>> changes = readProcessStateChanges(*snapshot->processes, state.fdCache);
+        if (!changes.empty()) {
+            auto processes = make_shared<ProcessStore>(*snapshot->processes);
+            applyProcessStateChanges(*processes, changes, now);
+            map<char, int> stateCounts = emptyProcessStateCounts();
+            for (char state : processes->state) {
+                auto it = stateCounts.find(state);
+                if (it != stateCounts.end()) it->second++;
+            }
+            snapshot->topCounts = summarizeProcessStates(stateCounts);
+            snapshot->processStates = move(stateCounts);
+            snapshot->processes = move(processes);
+        }
+        schedule.lastStates = now;
+    }
+
+    if (networkDue) {
+        // The copied snapshot still holds the previous sample to diff against
+        vector<NetworkInterface> interfaces = getNetworkInterfaces(&state.networkAddresses);
+        computeNetworkRates(interfaces, snapshot->interfaces, now - snapshot->networkSampledAt);
+        snapshot->interfaces = move(interfaces);
+        snapshot->networkSampledAt = now;
+        schedule.lastNetwork = now;
+    }
+
+    if (sensorsDue) {
+        snapshot->thermal = getThermalInfo();
+        snapshot->fans = getFanInfo();
+        snapshot->sensorsSampledAt = now;
+        schedule.lastSensors = now;
+    }
+
+    // A stall refreshes pressure out of turn but leaves the schedule alone, so
+    // the next regular read still lands on the shared tick with everything else
+    if (pressureDue || pressureStall) {
+        snapshot->pressure = getPressureInfo();
+        snapshot->pressureSampledAt = now;
+        snapshot->pressureTriggersActive = state.pressureTriggers.active();
+        snapshot->pressureStalls = state.pressureTriggers.events();
+        if (pressureDue) schedule.lastPressure = now;
+    }
+
+    return snapshot;
+}
+
+// Seconds until the next collector becomes due
+static double secondsUntilDue(const SamplerConfig& config, const SamplerSchedule& schedule, double now)
+{
+    double next = min({schedule.lastCPU + config.cpuInterval,
+                       schedule.lastMemory + config.memoryInterval,
+                       schedule.lastDisk + config.diskInterval,
+                       schedule.lastDiskIO + config.diskIOInterval,
+                       schedule.lastProcesses + config.processInterval,
+                       schedule.lastStates + config.stateInterval,
+                       schedule.lastNetwork + config.networkInterval,
+                       schedule.lastSensors + config.sensorInterval,
+                       schedule.lastPressure + config.pressureInterval,
+                       schedule.lastStatic + config.staticInterval});
+    return max(0.0, next - now);
+}
+
+void startSampler(const SamplerConfig& config)
+{
+    if (samplerThread.joinable()) return;
+
+    auto start = chrono::steady_clock::now();
+    auto elapsed = [start]() {
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    };
+
+    auto state = make_shared<SamplerState>(config);
+
+    // Collect once up front so the first frame already has data to show
+    shared_ptr<const SystemSnapshot> first = collectDue(config, *state, elapsed());
+    atomic_store(&latestSnapshot, first);
+    state->recorder.append(first);
+
+    samplerStop = false;
+    samplerThread = thread([config, state, elapsed]() {
+        while (true) {
+            bool pressureStall;
+            {
+                unique_lock<mutex> lock(samplerMutex);
+                auto wait = chrono::duration<double>(secondsUntilDue(config, state->schedule, elapsed()));
+                samplerWake.wait_for(lock, wait, [] { return samplerStop || samplerPressureStall; });
+                if (samplerStop) break;
+                pressureStall = samplerPressureStall;
+                samplerPressureStall = false;
+            }
+
+            auto snapshot = collectDue(config, *state, elapsed(), pressureStall);
+            if (snapshot) {
+                shared_ptr<const SystemSnapshot> published = snapshot;
+                atomic_store(&latestSnapshot, published);
+                state->recorder.append(published);
+                if (config.onSnapshot) config.onSnapshot();
+            }
+        }
+
+        // Finish the recording's index while the thread still owns the state
+        state->recorder.close();
+        state->pressureTriggers.close();
+    });
+}
+
+void stopSampler()
+{
+    if (!samplerThread.joinable()) return;
+
+    {
+        lock_guard<mutex> lock(samplerMutex);
+        samplerStop = true;
+    }
+    samplerWake.notify_all();
+    samplerThread.join();
+}
+
+// Latest published snapshot; readers keep it alive for as long as they hold it
+shared_ptr<const SystemSnapshot> getLatestSnapshot()
+{
+    return atomic_load(&latestSnapshot);
+}
+
+void publishSnapshot(shared_ptr<const SystemSnapshot> snapshot)
+{
+    atomic_store(&latestSnapshot, snapshot);
+}
@@ -1,4 +1,5 @@
 #include "header.h"
+#include <sys/eventfd.h>
 
 // get cpu id and information from /proc/cpuinfo
 string CPUinfo()
@@ -78,27 +79,19 @@ CPUStats getCPUStats()
     return stats;
 }
 
-// Calculate CPU usage percentage
-double getCPUUsage()
+// CPU usage percentage between two samples of the aggregate row
+double cpuUsageBetween(const CPUStats& prev, const CPUStats& current)
 {
-    static CPUStats prevStats = {0};
-    static bool firstCall = true;
-
-    CPUStats currentStats = getCPUStats();
-
-    if (firstCall) {
-        prevStats = currentStats;
-        firstCall = false;
-        return 0.0;
-    }
+    // No previous sample yet: report 0 rather than the average since boot
+    if (prev.user + prev.system + prev.idle == 0) return 0.0;
 
-    long long prevIdle = prevStats.idle + prevStats.iowait;
-    long long idle = currentStats.idle + currentStats.iowait;
+    long long prevIdle = prev.idle + prev.iowait;
+    long long idle = current.idle + current.iowait;
 
-    long long prevNonIdle = prevStats.user + prevStats.nice + prevStats.system +
-                           prevStats.irq + prevStats.softirq + prevStats.steal;
-    long long nonIdle = currentStats.user + currentStats.nice + currentStats.system +
-                       currentStats.irq + currentStats.softirq + currentStats.steal;
+    long long prevNonIdle = prev.user + prev.nice + prev.system +
+                           prev.irq + prev.softirq + prev.steal;
+    long long nonIdle = current.user + current.nice + current.system +
+                       current.irq + current.softirq + current.steal;
 
     long long prevTotal = prevIdle + prevNonIdle;
     long long total = idle + nonIdle;
@@ -111,12 +104,116 @@ double getCPUUsage()
         cpuPercentage = (double)(totalDiff - idleDiff) / totalDiff * 100.0;
     }
 
+    return cpuPercentage;
+}
+
+// Calculate CPU usage percentage
+double getCPUUsage()
+{
+    static CPUStats prevStats = {0};
+
+    CPUStats currentStats = getCPUStats();
+    double cpuPercentage = cpuUsageBetween(prevStats, currentStats);
+
     prevStats = currentStats;
     return cpuPercentage;
 }
 
-// Get process count by state
-map<char, int> getProcessCountByState()
+// Read the aggregate row and every cpuN row of /proc/stat in one pass.
+// The buffer is kept between calls and only grows if the cpu rows do not fit.
+bool readCPUStats(CPUStats& total, CoreStats& cores)
+{
+    static vector<char> buf(16384);
+
+    total = {0};
+    cores.ids.clear();
+    cores.busy.clear();
+    cores.total.clear();
+
+    while (true) {
+        ssize_t len = readProcFile("/proc/stat", buf.data(), buf.size());
+        if (len <= 0) return false;
+
+        const char* p = buf.data();
+        const char* end = p + len;
+        bool complete = false;
+
+        while (p < end) {
+            const char* eol = (const char*)memchr(p, '\n', end - p);
+            if (eol == nullptr) break; // row cut off by the buffer
+
+            // cpu rows come first; stop at intr, ctxt, ...
+            if (end - p < 3 || memcmp(p, "cpu", 3) != 0) {
+                complete = true;
+                break;
+            }
+
+            bool aggregate = p[3] == ' ';
+            long long id = 0;
+            const char* q = scanNumber(p + 3, eol, id);
+            while (q < eol && *q != ' ') q++;
+
+            long long fields[10] = {0};
+            for (int i = 0; i < 10 && q < eol; i++) {
+                while (q < eol && *q == ' ') q++;
+                q = scanNumber(q, eol, fields[i]);
+            }
+
+            if (aggregate) {
+                total.user = fields[0];
+                total.nice = fields[1];
+                total.system = fields[2];
+                total.idle = fields[3];
+                total.iowait = fields[4];
+                total.irq = fields[5];
+                total.softirq = fields[6];
+                total.steal = fields[7];
+                total.guest = fields[8];
+                total.guestNice = fields[9];
+            } else {
+                long long busy = fields[0] + fields[1] + fields[2] + fields[5] + fields[6] + fields[7];
+                cores.ids.push_back((int)id);
+                cores.busy.push_back(busy);
+                cores.total.push_back(busy + fields[3] + fields[4]);
+            }
+
+            p = eol + 1;
+        }
+
+        if (complete || len < (ssize_t)buf.size() - 1) return true;
+
+        // Filled the whole buffer inside the cpu rows: grow and read again
+        buf.resize(buf.size() * 2);
+        cores.ids.clear();
+        cores.busy.clear();
+        cores.total.clear();
+    }
+}
+
+// Per-core CPU% from two samples; a straight loop over the arrays
+void computeCoreUsage(const CoreStats& prev, const CoreStats& current, vector<float>& usage)
+{
+    size_t count = current.size();
+    usage.assign(count, 0.0f);
+
+    // Cores came online or went offline: wait for a second sample
+    if (prev.ids != current.ids) return;
+
+    const long long* prevBusy = prev.busy.data();
+    const long long* prevTotal = prev.total.data();
+    const long long* busy = current.busy.data();
+    const long long* total = current.total.data();
+    float* out = usage.data();
+
+    for (size_t i = 0; i < count; i++) {
+        long long busyDiff = busy[i] - prevBusy[i];
+        long long totalDiff = max(total[i] - prevTotal[i], 1LL);
+        out[i] = 100.0f * (float)busyDiff / (float)totalDiff;
+    }
+}
+
+// Process states tracked by the task overview, all starting at zero
+map<char, int> emptyProcessStateCounts()
 {
     map<char, int> stateCounts;
     stateCounts['R'] = 0; // Running
@@ -127,63 +224,51 @@ map<char, int> getProcessCountByState()
     stateCounts['t'] = 0; // Tracing stop
     stateCounts['X'] = 0; // Dead
     stateCounts['I'] = 0; // Idle
-
-    DIR* procDir = opendir("/proc");
-    if (procDir == nullptr) return stateCounts;
-
-    struct dirent* entry;
-    while ((entry = readdir(procDir)) != nullptr) {
-        // Check if directory name is a number (PID)
-        if (strspn(entry->d_name, "0123456789") == strlen(entry->d_name)) {
-            string statPath = "/proc/" + string(entry->d_name) + "/stat";
-            ifstream statFile(statPath);
-            string line;
-
-            if (getline(statFile, line)) {
-                // Parse the stat file to get the state (3rd field)
-                size_t pos = line.find(')');
-                if (pos != string::npos && pos + 2 < line.length()) {
-                    char state = line[pos + 2];
-                    if (stateCounts.find(state) != stateCounts.end()) {
-                        stateCounts[state]++;
-                    }
-                }
-            }
-        }
-    }
-
-    closedir(procDir);
     return stateCounts;
 }
 
-// Get total task count (matches 'top' command output)
-int getTotalTaskCount()
+// Group a per-state histogram like 'top' command does
+map<string, int> summarizeProcessStates(const map<char, int>& stateCounts)
 {
-    map<char, int> stateCounts = getProcessCountByState();
-    int total = 0;
+    auto count = [&stateCounts](char state) {
+        auto it = stateCounts.find(state);
+        return it != stateCounts.end() ? it->second : 0;
+    };
+
+    map<string, int> topCounts;
 
     // Sum all process states to get total
+    int total = 0;
     for (const auto& pair : stateCounts) {
         total += pair.second;
     }
 
-    return total;
+    topCounts["total"] = total;
+    topCounts["running"] = count('R');
+    // Top groups S (sleeping), I (idle), and D (disk sleep) as "sleeping"
+    topCounts["sleeping"] = count('S') + count('I') + count('D');
+    topCounts["stopped"] = count('T') + count('t');
+    topCounts["zombie"] = count('Z');
+
+    return topCounts;
 }
 
-// Get process counts grouped like 'top' command
-map<string, int> getTopStyleProcessCounts()
+// Get process count by state
+map<char, int> getProcessCountByState()
 {
-    map<char, int> stateCounts = getProcessCountByState();
-    map<string, int> topCounts;
+    return scanProcesses().stateCounts;
+}
 
-    topCounts["total"] = getTotalTaskCount();
-    topCounts["running"] = stateCounts['R'];
-    // Top groups S (sleeping), I (idle), and D (disk sleep) as "sleeping"
-    topCounts["sleeping"] = stateCounts['S'] + stateCounts['I'] + stateCounts['D'];
-    topCounts["stopped"] = stateCounts['T'] + stateCounts['t'];
-    topCounts["zombie"] = stateCounts['Z'];
+// Get total task count (matches 'top' command output)
+int getTotalTaskCount()
+{
+    return scanProcesses().topCounts["total"];
+}
 
-    return topCounts;
+// Get process counts grouped like 'top' command, from a single /proc walk
+map<string, int> getTopStyleProcessCounts()
+{
+    return scanProcesses().topCounts;
 }
 
 // Get thermal information from /sys/class/thermal and /proc/acpi/ibm/thermal
@@ -276,3 +361,156 @@ vector<FanInfo> getFanInfo()
 
     return fanData;
 }
+
+static const char* pressureResources[] = {"cpu", "memory", "io"};
+
+// One pressure line: "some avg10=1.94 avg60=1.94 avg300=1.69 total=55587833"
+static void parsePressureLine(const char* p, const char* eol, PressureLine& line)
+{
+    while (p < eol) {
+        const char* eq = (const char*)memchr(p, '=', eol - p);
+        if (eq == nullptr) break;
+        const char* key = p;
+        size_t keyLength = eq - p;
+        char* next = nullptr;
+
+        if (keyLength == 5 && memcmp(key, "total", 5) == 0) {
+            long long value;
+            p = scanNumber(eq + 1, eol, value);
+            line.total = value;
+        } else {
+            double value = strtod(eq + 1, &next);
+            if (keyLength == 5 && memcmp(key, "avg10", 5) == 0) line.avg10 = value;
+            if (keyLength == 5 && memcmp(key, "avg60", 5) == 0) line.avg60 = value;
+            if (keyLength == 6 && memcmp(key, "avg300", 6) == 0) line.avg300 = value;
+            p = next;
+        }
+        while (p < eol && *p == ' ') p++;
+    }
+}
+
+// Empty when the kernel has no PSI (older than 4.20, or psi=0 on the command line)
+vector<PressureInfo> getPressureInfo()
+{
+    vector<PressureInfo> pressure;
+
+    for (const char* resource : pressureResources) {
+        char path[64];
+        char buf[256];
+        snprintf(path, sizeof(path), "/proc/pressure/%s", resource);
+        ssize_t len = readProcFile(path, buf, sizeof(buf));
+        if (len <= 0) continue;
+
+        PressureInfo info;
+        info.resource = resource;
+        const char* p = buf;
+        const char* end = buf + len;
+        while (p < end) {
+            const char* eol = (const char*)memchr(p, '\n', end - p);
+            if (eol == nullptr) eol = end;
+            if (eol - p > 5 && memcmp(p, "some ", 5) == 0) {
+                parsePressureLine(p + 5, eol, info.some);
+            } else if (eol - p > 5 && memcmp(p, "full ", 5) == 0) {
+                parsePressureLine(p + 5, eol, info.full);
+                info.hasFull = true;
+            }
+            p = eol + 1;
+        }
+        pressure.push_back(info);
+    }
+
+    return pressure;
+}
+
+PressureTriggers::~PressureTriggers()
+{
+    close();
+}
+
+// Register a trigger on every pressure file that accepts one. Returns false
+// when none do: no PSI, or an unprivileged user on a kernel that only allows
+// windows in multiples of 2s.
+bool PressureTriggers::open(unsigned stallUs, unsigned windowUs, function<void()> onStall)
+{
+    close();
+    if (windowUs == 0) return false;
+
+    // Without CAP_SYS_RESOURCE the window must be a multiple of 2s, so a refused
+    // trigger is retried on the next such window with the same stall ratio
+    const unsigned unprivilegedUs = 2000000;
+    unsigned roundedUs = (windowUs + unprivilegedUs - 1) / unprivilegedUs * unprivilegedUs;
+    char triggers[2][64];
+    int lengths[2];
+    lengths[0] = snprintf(triggers[0], sizeof(triggers[0]), "some %u %u", stallUs, windowUs);
+    lengths[1] = snprintf(triggers[1], sizeof(triggers[1]), "some %u %u",
+                          (unsigned)((uint64_t)stallUs * roundedUs / windowUs), roundedUs);
+
+    for (const char* resource : pressureResources) {
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/pressure/%s", resource);
+
+        // A file holds one trigger per descriptor, so a refused write needs a fresh open
+        for (int attempt = 0; attempt < 2; attempt++) {
+            if (attempt && roundedUs == windowUs) break;
+            int fd = ::open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+            if (fd < 0) break;
+
+            // The kernel wants the terminating NUL as part of the write
+            if (write(fd, triggers[attempt], lengths[attempt] + 1) < 0) {
+                ::close(fd);
+                continue;
+            }
+            fds.push_back(fd);
+            break;
+        }
+    }
+    if (fds.empty()) return false;
+
+    wakeFd = eventfd(0, EFD_CLOEXEC);
+    if (wakeFd < 0) {
+        close();
+        return false;
+    }
+
+    watcher = thread([this, onStall]() {
+        vector<struct pollfd> pfds;
+        for (int fd : fds) pfds.push_back({fd, POLLPRI, 0});
+        pfds.push_back({wakeFd, POLLIN, 0});
+
+        while (true) {
+            if (poll(pfds.data(), pfds.size(), -1) < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            if (pfds.back().revents) break; // close()
+
+            bool stalled = false;
+            for (size_t i = 0; i + 1 < pfds.size(); i++) {
+                // POLLERR means the pressure file went away
+                if (pfds[i].revents & POLLERR) return;
+                if (pfds[i].revents & POLLPRI) stalled = true;
+            }
+            if (stalled) {
+                eventCount++;
+                if (onStall) onStall();
+            }
+        }
+    });
+    return true;
+}
+
+void PressureTriggers::close()
+{
+    if (watcher.joinable()) {
+        uint64_t one = 1;
+        ssize_t written = write(wakeFd, &one, sizeof(one));
+        (void)written;
+        watcher.join();
+    }
+    if (wakeFd >= 0) {
+        ::close(wakeFd);
+        wakeFd = -1;
+    }
+    for (int fd : fds) ::close(fd);
+    fds.clear();
+}